@@ -1,164 +1,846 @@
 #pragma once
 #include <DatArchive/DatArchiveCommon.h>
+#include <DatArchive/DatAsyncIo.h>
+#include <DatArchive/DatAwaitable.h>
+#include <DatArchive/DatCodec.h>
+#include <DatArchive/DatEntryCache.h>
+#include <DatArchive/DatEntryReader.h>
+#include <DatArchive/DatInflater.h>
+#include <DatArchive/DatMappedFile.h>
+#include <DatArchive/DatPathHash.h>
+#include <DatArchive/DatPositionalFile.h>
+#include <DatArchive/DatThreadPool.h>
+#include <DatArchive/DatVerifier.h>
 
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string_view>
 #include <utility>
 
+/**
+ * Reads files out of a dat archive
+ * Once open, getFile and getFileView can be called from any number of threads at the same time, as every read is positional
+ */
 class DatFile {
-	std::fstream datFile;
+	DatPositionalFile datFile;
 	uint8_t version = 0;
-	std::unordered_map<std::string, DatFileEntry> fileTable;
+	DatMappedFile mappedFile;
+
+	// The table in the version 3 layout, either pointing into the mapping or into ownedTable
+	std::vector<char> ownedTable;
+	const char* records = nullptr;
+	const char* namePool = nullptr;
+	uint32_t entryCount = 0;
+	uint16_t recordSize = 0;
+	uint64_t namePoolSize = 0;
+
+	// Which checksum the records hold, always CRC32 before version 9
+	uint8_t checksumType = DATCHECKSUMCRC32;
+
+	// The perfect hash over the names, only in version 4 and later tables
+	const char* hashSeeds = nullptr;
+	const char* hashSlots = nullptr;
+	uint32_t hashBucketCount = 0;
+
+	// Where each block of the entries split into blocks starts, only in version 5 and later tables
+	const char* blockIndex = nullptr;
+	uint64_t blockIndexCount = 0;
+	int64_t blockSize = 0;
+
+	// The dictionaries entries were compressed against and their sizes, pointing into the table, only in version 7 and later tables
+	std::vector<std::pair<const char*, uint32_t>> dictionaries;
+
+	// The solid blocks small files are grouped into, only in version 8 and later tables
+	const char* solidIndex = nullptr;
+	uint32_t solidCount = 0;
+
+	// Decompressed files handed out by getCachedFile, disabled until it is given a budget
+	mutable DatEntryCache cache;
+
+	// Decompressed solid blocks, so files from the same block don't decompress it again
+	static const size_t SOLIDCACHEBUDGET = 8 * 1024 * 1024;
+	mutable DatEntryCache solidCache{SOLIDCACHEBUDGET};
+
+	// Compressed data bigger than this isn't staged whole before it is decompressed, it is read and decompressed a window at a time
+	static const int64_t STAGINGBUFFERLIMIT = 4 * 1024 * 1024;
+	static constexpr int64_t STREAMWINDOW = 1024 * 1024;
+
+	// ZLib only takes 32 bits worth of size at a time, so bigger buffers are fed through it in windows of this size
+	static constexpr int64_t ZLIBWINDOW = 1 << 30;
+
+	// Which reads are checked against their checksums, and who is told when one doesn't match
+	// Its slots are the records, then the solid blocks, then the blocks in the block index
+	mutable DatVerifier verifier;
+	DatIntegrityHandler integrityHandler;
+
+	// The ring getFileAsync hands reads to, set up by the first async read, and nullptr if io_uring isn't available
+	mutable std::mutex asyncMutex;
+	mutable std::unique_ptr<DatAsyncIo> asyncIo;
+	mutable bool asyncTried = false;
+
+	// getFiles reads files stored at most coalesceGap bytes apart with one request, up to COALESCELIMIT bytes at a time
+	static const int64_t COALESCEGAP = 64 * 1024;
+	static const int64_t COALESCELIMIT = 16 * 1024 * 1024;
+	int64_t coalesceGap = COALESCEGAP;
 	
 public:
 	DatFile() = default;
 
-	explicit DatFile(const std::filesystem::path& Path) {
-		openFile(Path);
+	explicit DatFile(const std::filesystem::path& Path, bool MemoryMap = false) {
+		openFile(Path, MemoryMap);
 	}
 
-	~DatFile() {
-		fileTable.clear();
+private:
+	/**
+	 * Reads raw bytes from the archive, out of the mapping if there is one
+	 * @param Offset The offset in the archive of the first byte to read
+	 * @param Buffer The buffer to read into (assumed to be big enough for Length bytes)
+	 * @param Length The amount of bytes to read
+	 * @return Whether all of the bytes were read
+	 */
+	bool readRaw(int64_t Offset, char* Buffer, size_t Length) const {
+		if (mappedFile.isOpen()) {
+			if (!mappedFile.containsRange(Offset, (int64_t) Length)) return false;
+			memcpy(Buffer, mappedFile.data() + Offset, Length);
+			return true;
+		}
+
+		return datFile.readAt(Offset, Buffer, Length);
 	}
 
+public:
 	/**
-	 * Opens the given archive, builds the filetable in the process
+	 * Opens the given archive, getting the file table in the process
+	 * The whole table is fetched with a single read (or none if the archive is memory mapped)
+	 * Version 3 tables are used in place without touching their entries, version 2 tables are converted to the version 3 layout
 	 * @param TheFile The directory of the file to open
+	 * @param MemoryMap Whether to map the archive into memory and serve reads from the mapping instead of the stream
 	 * @return whether archive was successfully opened
 	 */
-	bool openFile(const std::filesystem::path& TheFile) {
-		// Open file as a binary, ensure its a file
-		datFile.open(TheFile, std::ios::in | std::ios::binary);
-		if (!datFile) {
+	bool openFile(const std::filesystem::path& TheFile, bool MemoryMap = false) {
+		// The ring reads from the previous file, so finish with it first
+		{
+			std::lock_guard<std::mutex> lock(asyncMutex);
+			asyncIo.reset();
+			asyncTried = false;
+		}
+
+		// Forget the previous archive, so a failed open leaves nothing pointing into it and a switch of mode doesn't read from it
+		mappedFile.close();
+		datFile.close();
+		version = 0;
+		ownedTable.clear();
+		records = nullptr;
+		namePool = nullptr;
+		entryCount = 0;
+		recordSize = 0;
+		namePoolSize = 0;
+		checksumType = DATCHECKSUMCRC32;
+		hashSeeds = nullptr;
+		hashSlots = nullptr;
+		hashBucketCount = 0;
+		blockIndex = nullptr;
+		blockIndexCount = 0;
+		blockSize = 0;
+		dictionaries.clear();
+		solidIndex = nullptr;
+		solidCount = 0;
+		cache.clear();
+		solidCache.clear();
+		verifier.reset(0);
+
+		// Reads either come out of a mapping of the archive, or from positional reads of it
+		if (MemoryMap) {
+			if (!mappedFile.open(TheFile)) return false;
+		} else if (!datFile.open(TheFile)) {
 			return false;
 		}
 
-		// Read the signature, check its the right one
-		char signature[4];
-		datFile.read(signature, 4);
+		int64_t fileSize = MemoryMap ? (int64_t) mappedFile.size() : datFile.size();
+
+		// Read the header, signature (4), version (1), and table offset (8)
+		char header[13];
+		if (fileSize < 13 || !readRaw(0, header, 13)) {
+			return false;
+		}
 
-		if (!strcmp(signature, DATFILESIGNATURE)) {
+		// Check the signature is the right one
+		if (memcmp(header, DATFILESIGNATURE, 4) != 0) {
 			return false;
 		}
 
-		// Get the version of the file, check it's the right one
-		datFile.read(reinterpret_cast<char*>(&version), 1);
+		// Get the version of the file, check it's one we can read
+		version = (uint8_t) header[4];
 
-		if (version != DATFILEVERSION) {
+		if (version < DATFILEMINVERSION || version > DATFILEVERSION) {
 			return false;
 		}
 
 		// Get the table offset
 		int64_t tableOffset;
+		memcpy(&tableOffset, header + 5, 8);
 
-		datFile.read(reinterpret_cast<char*>(&tableOffset), 8);
+		if (tableOffset < 13 || tableOffset > fileSize) {
+			return false;
+		}
 
-		// Go to the table
-		datFile.seekg(tableOffset);
+		// Get the whole table, from the table offset to the end of the file
+		size_t tableSize = (size_t) (fileSize - tableOffset);
+		std::vector<char> tableBuffer;
+		const char* table;
 
-		// Build the File Table
-		DatFileEntry entry;
-		std::string fileName;
-		uint8_t buffer;
-		while (datFile.read(reinterpret_cast<char*>(&buffer), 1) && !datFile.fail()) {
-			char* name = new char[buffer + 1];
+		if (MemoryMap) {
+			table = reinterpret_cast<const char*>(mappedFile.data()) + tableOffset;
+		} else {
+			tableBuffer.resize(tableSize);
+			if (!datFile.readAt(tableOffset, tableBuffer.data(), tableSize)) return false;
+			table = tableBuffer.data();
+		}
+
+		// Version 2 tables are converted to the version 3 layout, version 3 tables are used as they are
+		if (version == 0x02) {
+			return convertV2Table(table, tableSize);
+		}
+
+		if (!MemoryMap) {
+			ownedTable = std::move(tableBuffer);
+			table = ownedTable.data();
+		}
+		return useTable(table, tableSize);
+	}
+
+private:
+	/**
+	 * Points the lookups at a table in the version 3 layout, without touching any of its entries
+	 * @param Table A pointer to the start of the table, must stay valid while the archive is open
+	 * @param TableSize The size of the table in bytes
+	 * @return Whether the table is well formed
+	 */
+	bool useTable(const char* Table, size_t TableSize) {
+		if (TableSize < DATFILETABLEHEADERSIZE) return false;
+
+		uint32_t count;
+		uint16_t size;
+		uint64_t poolSize;
+		memcpy(&count, Table, 4);
+		memcpy(&size, Table + 4, 2);
+		memcpy(&poolSize, Table + 8, 8);
+
+		// Records can grow in later versions, but never shrink
+		if (size < getRecordSize(version)) return false;
+
+		uint64_t recordsSize = (uint64_t) count * size;
+		if (recordsSize > TableSize - DATFILETABLEHEADERSIZE || poolSize > TableSize - DATFILETABLEHEADERSIZE - recordsSize) return false;
+
+		// Version 9 tables say which checksum the records hold
+		checksumType = DATCHECKSUMCRC32;
+		if (version >= 0x09) {
+			uint16_t checksum;
+			memcpy(&checksum, Table + 6, 2);
+			if (checksum > DATCHECKSUMXXH64) return false;
+			checksumType = (uint8_t) checksum;
+		}
+
+		entryCount = count;
+		recordSize = size;
+		namePoolSize = poolSize;
+		records = Table + DATFILETABLEHEADERSIZE;
+		namePool = records + recordsSize;
+
+		// Version 4 tables follow the name pool with the perfect hash, a bucket count of 0 means the writer couldn't build one
+		hashBucketCount = 0;
+		size_t hashOffset = DATFILETABLEHEADERSIZE + recordsSize + poolSize;
+		size_t hashEnd = hashOffset;
+		if (version >= 0x04) {
+			if (TableSize - hashOffset < DATFILEHASHHEADERSIZE) return false;
+
+			uint32_t bucketCount;
+			memcpy(&bucketCount, Table + hashOffset, 4);
+			hashEnd += DATFILEHASHHEADERSIZE;
+
+			if (bucketCount != 0) {
+				uint64_t hashSize = ((uint64_t) bucketCount + count) * 4;
+				if (hashSize > TableSize - hashEnd) return false;
+
+				hashBucketCount = bucketCount;
+				hashSeeds = Table + hashEnd;
+				hashSlots = hashSeeds + (size_t) bucketCount * 4;
+				hashEnd += hashSize;
+			}
+		}
+
+		// Version 5 tables follow the hash index with the block index
+		blockIndexCount = 0;
+		size_t blockEnd = hashEnd;
+		if (version >= 0x05) {
+			if (TableSize - hashEnd < DATFILEBLOCKHEADERSIZE) return false;
+
+			uint32_t size32;
+			uint64_t blocks;
+			memcpy(&size32, Table + hashEnd, 4);
+			memcpy(&blocks, Table + hashEnd + 8, 8);
+
+			if (blocks > (TableSize - hashEnd - DATFILEBLOCKHEADERSIZE) / DATFILEBLOCKENTRYSIZE) return false;
+			if (blocks != 0 && size32 == 0) return false;
+
+			blockIndexCount = blocks;
+			blockSize = size32;
+			blockIndex = Table + hashEnd + DATFILEBLOCKHEADERSIZE;
+			blockEnd = hashEnd + DATFILEBLOCKHEADERSIZE + (size_t) blocks * DATFILEBLOCKENTRYSIZE;
+		}
+
+		// Version 7 tables follow the block index with the dictionaries
+		dictionaries.clear();
+		size_t dictionaryEnd = blockEnd;
+		if (version >= 0x07) {
+			if (TableSize - blockEnd < DATFILEDICTIONARYHEADERSIZE) return false;
+
+			uint32_t dictionaryCount;
+			memcpy(&dictionaryCount, Table + blockEnd, 4);
+
+			size_t cursor = blockEnd + DATFILEDICTIONARYHEADERSIZE;
+			for (uint32_t i = 0; i < dictionaryCount; ++i) {
+				if (TableSize - cursor < DATFILEDICTIONARYENTRYSIZE) return false;
+
+				uint32_t dictionarySize;
+				memcpy(&dictionarySize, Table + cursor + 4, 4);
+				cursor += DATFILEDICTIONARYENTRYSIZE;
+				if (dictionarySize > TableSize - cursor) return false;
+
+				dictionaries.emplace_back(Table + cursor, dictionarySize);
+				cursor += dictionarySize;
+			}
+			dictionaryEnd = cursor;
+		}
+
+		// Version 8 tables end with the solid blocks
+		solidCount = 0;
+		if (version >= 0x08) {
+			if (TableSize - dictionaryEnd < DATFILESOLIDHEADERSIZE) return false;
+
+			uint32_t count32;
+			memcpy(&count32, Table + dictionaryEnd, 4);
+			if (count32 > (TableSize - dictionaryEnd - DATFILESOLIDHEADERSIZE) / DATFILESOLIDENTRYSIZE) return false;
+
+			solidCount = count32;
+			solidIndex = Table + dictionaryEnd + DATFILESOLIDHEADERSIZE;
+		}
+		cache.clear();
+		solidCache.clear();
+		verifier.reset((uint64_t) entryCount + solidCount + blockIndexCount);
+
+		return true;
+	}
+
+	/**
+	 * Builds a table in the version 3 layout from a version 2 table
+	 * Each version 2 entry is the name length (1), the name, then the file desc (1), crc (4), data size (8), data start (8), and data end (8)
+	 * @param Table A pointer to the start of the version 2 table
+	 * @param TableSize The size of the table in bytes
+	 * @return Whether the table was successfully converted
+	 */
+	bool convertV2Table(const char* Table, size_t TableSize) {
+		std::vector<std::pair<std::string_view, DatFileEntry>> entries;
 
-			datFile.read(name, buffer);
+		const char* cursor = Table;
+		const char* tableEnd = Table + TableSize;
 
-			// Null Terminate the name
-			name[buffer] = '\0';
+		DatFileEntry entry;
+		while (cursor < tableEnd) {
+			uint8_t nameLength = (uint8_t) *cursor;
+
+			// Stop at a truncated entry
+			if ((size_t) (tableEnd - cursor) < 1u + nameLength + 29u) break;
 
-			// Free up memory, invalidate pointer
-			fileName = (std::string) name;
-			delete[] name;
-			name = nullptr;
+			std::string_view name(cursor + 1, nameLength);
+			cursor += 1 + nameLength;
 
 			// File desc
-			datFile.read(reinterpret_cast<char*>(&buffer), 1);
-			entry.flags.setFlags(buffer);
-			entry.fileType = buffer & 0b00111111;
+			uint8_t desc = (uint8_t) *cursor;
+			entry.flags.setFlags(desc);
+			entry.fileType = desc & 0b00111111;
 
 			// CRC
-			datFile.read(reinterpret_cast<char*>(&entry.crc), 4);
+			memcpy(&entry.crc, cursor + 1, 4);
 
 			// Data Size
-			datFile.read(reinterpret_cast<char*>(&entry.dataSize), 8);
+			memcpy(&entry.dataSize, cursor + 5, 8);
 
 			// Set start and end points
-			datFile.read(reinterpret_cast<char*>(&entry.dataStart), 8);
-			datFile.read(reinterpret_cast<char*>(&entry.dataEnd), 8);
+			memcpy(&entry.dataStart, cursor + 13, 8);
+			memcpy(&entry.dataEnd, cursor + 21, 8);
+			cursor += 29;
+
+			entries.emplace_back(name, entry);
+		}
+
+		// Sort by name, if a name is in the table twice the later entry wins
+		std::stable_sort(entries.begin(), entries.end(), [](const auto& A, const auto& B) {
+			return A.first < B.first;
+		});
+
+		std::vector<std::pair<std::string_view, DatFileEntry>> unique;
+		unique.reserve(entries.size());
+		for (auto& it : entries) {
+			if (!unique.empty() && unique.back().first == it.first) unique.back() = it;
+			else unique.push_back(it);
+		}
+
+		// Lay out the header, records, and name pool
+		uint64_t poolSize = 0;
+		for (auto& it : unique) poolSize += it.first.size();
+
+		uint32_t count = (uint32_t) unique.size();
+		uint16_t size = (uint16_t) DATFILERECORDSIZE;
+		ownedTable.assign(DATFILETABLEHEADERSIZE + (size_t) count * DATFILERECORDSIZE + poolSize, 0);
+		memcpy(ownedTable.data(), &count, 4);
+		memcpy(ownedTable.data() + 4, &size, 2);
+		memcpy(ownedTable.data() + 8, &poolSize, 8);
+
+		char* record = ownedTable.data() + DATFILETABLEHEADERSIZE;
+		char* pool = record + (size_t) count * DATFILERECORDSIZE;
+		uint32_t nameOffset = 0;
+		for (auto& it : unique) {
+			it.second.writeRecord(record, nameOffset, (uint8_t) it.first.size());
+			memcpy(pool + nameOffset, it.first.data(), it.first.size());
+
+			record += DATFILERECORDSIZE;
+			nameOffset += (uint32_t) it.first.size();
+		}
+
+		return useTable(ownedTable.data(), ownedTable.size());
+	}
+
+	/**
+	 * Gets the name of the entry at the given index in the table
+	 * @param Index The index of the entry, must be less than entryCount
+	 * @return The name of the entry, or an empty name if the record points outside the name pool
+	 */
+	[[nodiscard]] std::string_view nameAt(uint32_t Index) const {
+		const char* record = records + (size_t) Index * recordSize;
+
+		uint32_t nameOffset;
+		memcpy(&nameOffset, record + 24, 4);
+		uint8_t nameLength = (uint8_t) record[32];
+
+		if ((uint64_t) nameOffset + nameLength > namePoolSize) return {};
+		return {namePool + nameOffset, nameLength};
+	}
+
+	/**
+	 * Gets the entry at the given index in the table
+	 * @param Index The index of the entry, must be less than entryCount
+	 * @return The entry
+	 */
+	[[nodiscard]] DatFileEntry entryAt(uint32_t Index) const {
+		DatFileEntry entry;
+		entry.readRecord(records + (size_t) Index * recordSize, recordSize);
+		entry.checksum = checksumType;
+		entry.tableIndex = Index;
+		return entry;
+	}
+
+	/**
+	 * Gets a block from the block index
+	 * @param Index The index of the block, must be less than blockIndexCount
+	 * @return The block
+	 */
+	[[nodiscard]] DatBlock blockAt(uint64_t Index) const {
+		DatBlock block;
+		memcpy(&block.offset, blockIndex + Index * DATFILEBLOCKENTRYSIZE, 8);
+		memcpy(&block.crc, blockIndex + Index * DATFILEBLOCKENTRYSIZE + 8, 4);
+		return block;
+	}
+
+	/**
+	 * Gets a solid block from the solid index, as an entry describing its compressed data
+	 * @param Index The index of the block, must be less than solidCount
+	 * @return The entry for the block
+	 */
+	[[nodiscard]] DatFileEntry solidAt(uint32_t Index) const {
+		const char* block = solidIndex + (size_t) Index * DATFILESOLIDENTRYSIZE;
+
+		DatFileEntry entry;
+		memcpy(&entry.dataSize, block, 8);
+		memcpy(&entry.dataStart, block + 8, 8);
+		memcpy(&entry.dataEnd, block + 16, 8);
+		memcpy(&entry.crc, block + 24, 4);
+		entry.codec = (uint8_t) block[28];
+		entry.flags.compressed = true;
+		entry.tableIndex = (uint64_t) entryCount + Index;
+		return entry;
+	}
+
+	/**
+	 * Finds the index of a file in the table
+	 * Uses the archive's perfect hash if it has one, otherwise records are sorted by name so this is a binary search
+	 * @param File The path to the file in the archive
+	 * @param Index Where to put the index of the file's record if it is found
+	 * @return Whether the file is in the table
+	 */
+	bool findIndex(std::string_view File, uint32_t& Index) const {
+		if (hashBucketCount != 0) {
+			// One hash gives the only record the name could be, then one compare checks it
+			uint64_t hash = DatPathHash::hash(File);
+
+			uint32_t seed;
+			memcpy(&seed, hashSeeds + (size_t) DatPathHash::bucket(hash, hashBucketCount) * 4, 4);
+
+			uint32_t slot = DatPathHash::slot(hash, seed, entryCount);
+			if (slot >= entryCount) return false;
+
+			memcpy(&Index, hashSlots + (size_t) slot * 4, 4);
+			return Index < entryCount && nameAt(Index) == File;
+		}
+
+		uint32_t low = 0;
+		uint32_t high = entryCount;
 
-			fileTable[fileName] = entry;
+		while (low < high) {
+			uint32_t middle = low + (high - low) / 2;
+			int comparison = nameAt(middle).compare(File);
+
+			if (comparison == 0) {
+				Index = middle;
+				return true;
+			}
+
+			if (comparison < 0) low = middle + 1;
+			else high = middle;
 		}
 
-		datFile.clear();
+		return false;
+	}
+
+	/**
+	 * Finds a file in the table
+	 * @param File The path to the file in the archive
+	 * @param Entry Where to put the entry for the file if it is found
+	 * @return Whether the file is in the table
+	 */
+	bool findEntry(std::string_view File, DatFileEntry& Entry) const {
+		uint32_t index;
+		if (!findIndex(File, index)) return false;
+
+		Entry = entryAt(index);
 		return true;
 	}
 
+public:
+	/**
+	 * Gets the format version of the open archive
+	 * @return The version from the archive's header
+	 */
+	[[nodiscard]] uint8_t getVersion() const {
+		return version;
+	}
+
+	/**
+	 * Sets how often reads are checked against their checksums, forgetting which entries have been verified so far
+	 * Checking every read is the safest, but re-reads of hot entries pay for a full checksum each time
+	 * DATVERIFYFIRSTREAD checks each entry until it matches once, then trusts it (and the OS page cache behind it) from then on
+	 * Should be set before reading from more than one thread
+	 * @param Policy One of the DATVERIFY values
+	 * @param SampleRate The fraction of reads checked by DATVERIFYSAMPLED, from 0 to 1
+	 */
+	void setVerifyPolicy(uint8_t Policy, double SampleRate = 0.01) {
+		verifier.setPolicy(Policy, SampleRate);
+	}
+
+	/**
+	 * Gets how often reads are checked against their checksums
+	 * @return One of the DATVERIFY values
+	 */
+	[[nodiscard]] uint8_t getVerifyPolicy() const {
+		return verifier.getPolicy();
+	}
+
+	/**
+	 * Sets what is called when data doesn't match its checksum, reads of that data fail either way
+	 * Called on whichever thread did the read, so it must be safe to call from any of them
+	 * Should be set before reading from more than one thread
+	 * @param Handler The handler, or an empty function to just fail the read
+	 */
+	void setIntegrityHandler(DatIntegrityHandler Handler) {
+		integrityHandler = std::move(Handler);
+	}
+
+	/**
+	 * Gets the checksum the open archive's entries are checked against
+	 * @return One of the DATCHECKSUM values
+	 */
+	[[nodiscard]] uint8_t getChecksumType() const {
+		return checksumType;
+	}
+
+	/**
+	 * Checks if reads are being served from a memory mapping of the archive
+	 * @return Whether the archive is memory mapped
+	 */
+	[[nodiscard]] bool isMemoryMapped() const {
+		return mappedFile.isOpen();
+	}
+
 	/**
 	 * Decompresses the first given stream into the second given stream
+	 * Uses the calling thread's inflater, so the inflate state is only allocated once per thread
+	 * Buffers of any size are fed through ZLib ZLIBWINDOW bytes at a time
 	 * @param In The buffer containing the compressed data
+	 * @param InSize The amount of compressed bytes
 	 * @param Out The buffer for the uncompressed data to end up in
+	 * @param OutSize The size of the uncompressed data
+	 * @param Dictionary The preset dictionary the data was compressed against, or nullptr for none
+	 * @param DictionarySize The size of the dictionary
 	 * @return The result of the decompression (Z_OK if successful)
 	 */
-	static int decompressToBuffer(char* In, uint32_t InSize, char* Out, uint32_t OutSize) {
+	static int decompressToBuffer(const char* In, int64_t InSize, char* Out, int64_t OutSize, const char* Dictionary = nullptr, uint32_t DictionarySize = 0) {
 		// Vars
 		int rc;
-		z_stream strm;
-
-		// Setup strm
-		strm.zalloc = Z_NULL;
-		strm.zfree = Z_NULL;
-		strm.opaque = Z_NULL;
-		strm.avail_in = 0;
-		strm.next_in = Z_NULL;
-
-		// Start inflation
-		rc = inflateInit(&strm);
-		if (rc != Z_OK)return rc;
-
-		strm.avail_in = InSize;
-		if (strm.avail_in == 0) {
-			inflateEnd(&strm);
-			return Z_DATA_ERROR;
-		}
+		z_stream* strm;
+
+		if (InSize <= 0) return Z_DATA_ERROR;
+
+		// Start inflation, reusing this thread's stream
+		rc = DatInflater::forThread().begin(strm);
+		if (rc != Z_OK) return rc;
+
+		// Since we know the decompressed size, and want to keep everything in memory, we can just point the in and out at 2 buffers in memory and inflate straight through
+		strm->avail_in = 0;
+		strm->next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(In));
+		// Empty files have no buffer, but zlib still wants somewhere to point at
+		unsigned char empty;
+		strm->avail_out = 0;
+		strm->next_out = OutSize != 0 ? reinterpret_cast<unsigned char*>(Out) : &empty;
+
+		int64_t inLeft = InSize;
+		int64_t outLeft = OutSize;
+		do {
+			// Move the windows on once they've been used up
+			if (strm->avail_in == 0) {
+				strm->avail_in = (uInt) std::min(inLeft, ZLIBWINDOW);
+				inLeft -= strm->avail_in;
+			}
+			if (strm->avail_out == 0) {
+				strm->avail_out = (uInt) std::min(outLeft, ZLIBWINDOW);
+				outLeft -= strm->avail_out;
+			}
+
+			rc = inflate(strm, Z_NO_FLUSH);
+			assert(rc != Z_STREAM_ERROR);  /* state not clobbered */
 
-		// Since we know the decompressed size, and want to keep everything in memory, we can just set the in and out to 2 buffers in memory and inflate all at once
-		strm.next_in = reinterpret_cast<unsigned char*>(In);
-		strm.avail_out = OutSize;
-		strm.next_out = reinterpret_cast<unsigned char*>(Out);
-		rc = inflate(&strm, Z_NO_FLUSH);
-		assert(rc != Z_STREAM_ERROR);  /* state not clobbered */
+			// Data compressed against a dictionary stops straight after the header to ask for it
+			if (rc == Z_NEED_DICT && Dictionary != nullptr) {
+				rc = inflateSetDictionary(strm, reinterpret_cast<const Bytef*>(Dictionary), DictionarySize);
+				if (rc != Z_OK) return Z_DATA_ERROR;
+				Dictionary = nullptr;
+			}
+		} while (rc == Z_OK);
 
-		// Check for errors
+		// Check for errors, the stream is reset on its next use so there's nothing to clean up
 		switch (rc) {
 		case Z_NEED_DICT:
-			rc = Z_DATA_ERROR;     /* and fall through */
+			return Z_DATA_ERROR;
 		case Z_DATA_ERROR:
 		case Z_MEM_ERROR:
-			(void)inflateEnd(&strm);
 			return rc;
 		}
 
-		// Clean up
-		inflateEnd(&strm);
 		return rc == Z_STREAM_END ? Z_OK : Z_DATA_ERROR;
 	}
 
+	/**
+	 * Decompresses the chunks of an entry that wasn't compressed with ZLib
+	 * Each chunk is its compressed size (4) followed by its data, and holds DATFILEBLOCKSIZE bytes of the file apart from the last
+	 * @param Codec The codec the entry was compressed with
+	 * @param In The buffer containing the compressed data
+	 * @param InSize The amount of compressed bytes
+	 * @param Out The buffer for the uncompressed data to end up in
+	 * @param OutSize The size of the uncompressed data
+	 * @return The result of the decompression (Z_OK if successful)
+	 */
+	static int decompressChunks(const DatCodec& Codec, const char* In, int64_t InSize, char* Out, int64_t OutSize) {
+		int64_t position = 0;
+
+		while (OutSize > 0) {
+			if (InSize - position < 4) return Z_DATA_ERROR;
+
+			uint32_t chunkSize;
+			memcpy(&chunkSize, In + position, 4);
+			position += 4;
+
+			bool stored = (chunkSize & DATFILECHUNKSTORED) != 0;
+			chunkSize &= ~DATFILECHUNKSTORED;
+			if (chunkSize > InSize - position) return Z_DATA_ERROR;
+
+			size_t outChunk = (size_t) std::min(OutSize, DATFILEBLOCKSIZE);
+			if (stored) {
+				if (chunkSize != outChunk) return Z_DATA_ERROR;
+				memcpy(Out, In + position, outChunk);
+			} else if (!Codec.decompress(In + position, chunkSize, Out, outChunk)) {
+				return Z_DATA_ERROR;
+			}
+
+			position += chunkSize;
+			Out += outChunk;
+			OutSize -= (int64_t) outChunk;
+		}
+
+		return position == InSize ? Z_OK : Z_DATA_ERROR;
+	}
+
+	/**
+	 * Inflates the start of a single block of an entry that was split into blocks
+	 * Uses the calling thread's raw inflater, blocks have no zlib header and only the last one ends the deflate stream
+	 * @param In The stored data of the block
+	 * @param InSize The amount of stored bytes
+	 * @param Out The buffer for the uncompressed data to end up in
+	 * @param OutSize The amount of uncompressed bytes wanted from the start of the block
+	 * @return The result of the decompression (Z_OK if successful)
+	 */
+	static int inflateBlock(const char* In, size_t InSize, char* Out, size_t OutSize) {
+		z_stream* strm;
+		int rc = DatInflater::forThreadRaw().begin(strm);
+		if (rc != Z_OK) return rc;
+
+		strm->avail_in = (uInt) InSize;
+		strm->next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(In));
+		strm->avail_out = (uInt) OutSize;
+		strm->next_out = reinterpret_cast<unsigned char*>(Out);
+		rc = inflate(strm, Z_NO_FLUSH);
+
+		// Stopping once there's enough output is fine, the rest of the block just isn't needed
+		if ((rc == Z_OK || rc == Z_STREAM_END) && strm->avail_out == 0) return Z_OK;
+		return rc == Z_OK || rc == Z_STREAM_END ? Z_DATA_ERROR : rc;
+	}
+
+    /**
+     * Tells the integrity handler about data that didn't match its checksum
+     * @param File The path to the file in the archive
+     * @param Block The block of the file that didn't match, or -1 if it was the whole file
+     * @param Checksum The checksum that was checked, one of the DATCHECKSUM values
+     * @param Expected The checksum in the table
+     * @param Received The checksum of the data
+     */
+    void reportIntegrityError(std::string_view File, int64_t Block, uint8_t Checksum, uint64_t Expected, uint64_t Received) const {
+        if (!integrityHandler) return;
+
+        DatIntegrityError error;
+        error.file = std::string(File);
+        error.block = Block;
+        error.checksum = Checksum;
+        error.expected = Expected;
+        error.received = Received;
+        integrityHandler(error);
+    }
+
+    /**
+     * Generates the checksum for the stored data of a file and checks it against the one in the table, if the verify policy asks for it
+     * CRC32s are generated with the fastest kernel the CPU has, see DatArchive/DatChecksum.h
+     * @param File The path to the file in the archive, used for reporting
+     * @param Entry The table entry for the file
+     * @param Data The stored (possibly compressed) data of the file
+     * @param DataSize The amount of stored bytes
+     * @return Whether the data matched, or wasn't checked
+     */
+    bool checkChecksum(std::string_view File, const DatFileEntry& Entry, const char* Data, int64_t DataSize) const {
+        if (!verifier.shouldVerify(Entry.tableIndex)) return true;
+        return matchChecksum(File, Entry, DatChecksum::compute(Entry.checksum, Data, (size_t) DataSize));
+    }
+
+    /**
+     * Checks a generated checksum against the one in the table, remembering the entry was verified if they match
+     * @param File The path to the file in the archive, used for reporting
+     * @param Entry The table entry for the file
+     * @param Generated The checksum of the file's stored data
+     * @return Whether the checksums match
+     */
+    bool matchChecksum(std::string_view File, const DatFileEntry& Entry, uint64_t Generated) const {
+        uint64_t expected = Entry.checksum == DATCHECKSUMXXH64 ? Entry.hash : Entry.crc;
+
+        if (expected != Generated) {
+            reportIntegrityError(File, -1, Entry.checksum, expected, Generated);
+            return false;
+        }
+
+        verifier.markVerified(Entry.tableIndex);
+        return true;
+    }
+
+    /**
+     * Checks the stored data of a file, then turns it into the contents of the file
+     * @param File The path to the file in the archive, used for reporting
+     * @param Entry The table entry for the file
+     * @param Stored The stored (possibly compressed) data of the file
+     * @param StoredSize The amount of stored bytes
+     * @param Buffer The buffer for the contents of the file (assumed to be the correct size already), may be the same as Stored if the file isn't compressed
+     * @return Whether the buffer was successfully filled
+     */
+    bool decodeFile(std::string_view File, const DatFileEntry& Entry, const char* Stored, int64_t StoredSize, char* Buffer) const {
+        // Generate and check the checksum to make sure the data is valid
+        if (!checkChecksum(File, Entry, Stored, StoredSize)) return false;
+
+        // Decompress the data if it's compressed
+        if (Entry.flags.compressed) {
+            if (Entry.codec == DATCODECZLIB) {
+                if (Entry.dictionary == 0) return decompressToBuffer(Stored, StoredSize, Buffer, Entry.dataSize) == Z_OK;
+
+                if (Entry.dictionary > dictionaries.size()) {
+                    std::cout << "File: " << File << " was compressed against a dictionary that isn't in the archive" << std::endl;
+                    return false;
+                }
+
+                const auto& dictionary = dictionaries[Entry.dictionary - 1];
+                return decompressToBuffer(Stored, StoredSize, Buffer, Entry.dataSize, dictionary.first, dictionary.second) == Z_OK;
+            }
+
+            const DatCodec* codec = DatCodec::get(Entry.codec);
+            if (codec == nullptr) {
+                std::cout << "File: " << File << " is compressed with codec " << (int) Entry.codec << ", which this build doesn't support" << std::endl;
+                return false;
+            }
+            return decompressChunks(*codec, Stored, StoredSize, Buffer, Entry.dataSize) == Z_OK;
+        }
+
+        if (Stored != Buffer) memcpy(Buffer, Stored, StoredSize);
+        return true;
+    }
+
+    /**
+     * Gets a buffer to stage compressed data in before it is decompressed
+     * Small data uses a scratch buffer kept by the calling thread, anything bigger than STAGINGBUFFERLIMIT gets its own buffer so threads don't hold onto lots of memory
+     * @param Size The amount of bytes needed
+     * @param Oversized Holds the buffer for anything too big for the scratch buffer, must outlive the use of the returned buffer
+     * @return A buffer of at least Size bytes
+     */
+    static char* stagingBuffer(int64_t Size, std::vector<char>& Oversized) {
+        if (Size > STAGINGBUFFERLIMIT) {
+            Oversized.resize(Size);
+            return Oversized.data();
+        }
+
+        thread_local std::vector<char> scratch;
+        if ((int64_t) scratch.size() < Size) scratch.resize(Size);
+        return scratch.data();
+    }
+
     /**
      * Gets a file from the archive as a vector of chars
      * @param filePath The part to the file in the archive
      * @return A vector containing all the bytes of the file in the archive
      */
-    std::vector<char> getFile(const std::string& filePath) {
-        if (!fileTable.count(filePath)) {
+    std::vector<char> getFile(std::string_view filePath) const {
+        DatFileEntry entry;
+        if (!findEntry(filePath, entry)) {
             std::cout << "Attempted to get file: " << filePath << ", but it doesn't exist" << std::endl;
             return {};
         }
-        DatFileEntry& entry = fileTable[filePath];
 
         // Create a buffer big enough for the data
         std::vector<char> buffer(entry.size());
 
-        if (getFile(filePath, buffer.data())) return buffer;
+        if (readFile(filePath, entry, buffer.data())) return buffer;
         else return {};
     }
 
@@ -169,54 +851,1043 @@ public:
 	 * @param buffer A pointer to a pointer to the buffer where the file data will end up (assumed to be the correct size already)
 	 * @return If the buffer was successfully filled
 	 */
-	bool getFile(const std::string& File, char* buffer) {
+	bool getFile(std::string_view File, char* buffer) const {
 		// Check if the table actually contains the file
-		if (!fileTable.count(File)) {
+		DatFileEntry entry;
+		if (!findEntry(File, entry)) {
 			std::cout << "Attempted to get file: " << File << ", but it doesn't exist" << std::endl;
             return false;
 		}
-		
-		// Get the table entry for the file, and work out where the data is
-		DatFileEntry& entry = fileTable[File];
-		int64_t dataSize = entry.dataEnd - entry.dataStart + 1;
 
-        char* destBuffer;
+		return readFile(File, entry, buffer);
+	}
 
-        if (entry.flags.compressed) {
-            destBuffer = new char[dataSize];
-        } else {
-            destBuffer = buffer;
-        }
+	/**
+	 * Finds a file in the archive once, so it can be fetched again and again without looking up its path
+	 * @param File The path to the file in the archive
+	 * @return A handle to the file, or an invalid handle if the file doesn't exist
+	 */
+	[[nodiscard]] AssetHandle resolve(std::string_view File) const {
+		AssetHandle handle;
+		if (!findIndex(File, handle.index)) handle.index = AssetHandle::INVALID;
+		return handle;
+	}
 
-		// Goto and read the data
-		datFile.seekg(entry.dataStart);
-		if (!datFile.read(destBuffer, dataSize).good()) {
-            if (entry.flags.compressed) delete[] destBuffer;
-            return false;
-        }
+	/**
+	 * Gets a file from the archive as a vector of chars, using a handle from resolve
+	 * @param Handle The handle to the file, from this archive
+	 * @return A vector containing all the bytes of the file in the archive
+	 */
+	std::vector<char> getFile(AssetHandle Handle) const {
+		if (!isValid(Handle)) {
+			std::cout << "Attempted to get a file with an invalid handle" << std::endl;
+			return {};
+		}
 
-		// Generate and check the crc to make sure the data is valid
-		uint32_t generatedCrc = crc32(0L, reinterpret_cast<unsigned char*>(destBuffer), dataSize);
-		if (entry.crc != generatedCrc) {
-			std::cout << "File: " << File << " does not match its expected CRC, this usually means the data is corrupt" << std::endl << "Expected: " << std::hex << entry.crc << ", Received: " << generatedCrc << std::dec << std::endl;
-        }
+		DatFileEntry entry = entryAt(Handle.index);
+		std::vector<char> buffer(entry.size());
 
-		// Decompress the data if it's compressed
-		if (entry.flags.compressed) {
-			decompressToBuffer(destBuffer, dataSize, buffer, entry.dataSize);
-            delete[] destBuffer;
+		if (readFile(nameAt(Handle.index), entry, buffer.data())) return buffer;
+		else return {};
+	}
+
+	/**
+	 * Gets a file from the archive as a char array, using a handle from resolve
+	 * Warning, this function assumes that the buffer is already big enough to store the file
+	 * @param Handle The handle to the file, from this archive
+	 * @param buffer The buffer where the file data will end up (assumed to be the correct size already)
+	 * @return If the buffer was successfully filled
+	 */
+	bool getFile(AssetHandle Handle, char* buffer) const {
+		if (!isValid(Handle)) {
+			std::cout << "Attempted to get a file with an invalid handle" << std::endl;
+			return false;
 		}
 
-        return true;
+		return readFile(nameAt(Handle.index), entryAt(Handle.index), buffer);
 	}
 
-    /**
-     * Gets the header for the file at the address
-     * @param filePath
-     * @return
+	/**
+	 * Checks if a handle refers to a file in this archive
+	 * @param Handle The handle to check
+	 * @return Whether the handle can be used with this archive
+	 */
+	[[nodiscard]] bool isValid(AssetHandle Handle) const {
+		return Handle.index < entryCount;
+	}
+
+	/**
+	 * Sets how many bytes of decompressed files getCachedFile can keep around, the least recently used files are evicted to stay under it
+	 * @param Bytes The budget in bytes, 0 disables the cache
+	 */
+	void setCacheBudget(size_t Bytes) {
+		cache.setBudget(Bytes);
+	}
+
+	/**
+	 * Gets the hit, miss, and eviction counters for the cache used by getCachedFile
+	 * @return The counters, and the current size and budget of the cache
+	 */
+	[[nodiscard]] DatCacheStats getCacheStats() const {
+		return cache.getStats();
+	}
+
+	/**
+	 * Sets how far apart files can be stored for getFiles to read them with a single request, skipping over the data between them
+	 * Bigger gaps mean fewer requests, which suits spinning disks and network storage, at the cost of reading data that isn't needed
+	 * @param Bytes The biggest gap in bytes, 0 only merges files stored right next to each other
+	 */
+	void setCoalesceGap(int64_t Bytes) {
+		coalesceGap = Bytes < 0 ? 0 : Bytes;
+	}
+
+	/**
+	 * Sets how many bytes of decompressed solid blocks to keep around, so files from the same block don't decompress it again
+	 * @param Bytes The budget in bytes, 0 decompresses the block for every file read from it
+	 */
+	void setSolidCacheBudget(size_t Bytes) {
+		solidCache.setBudget(Bytes);
+	}
+
+	/**
+	 * Gets the hit, miss, and eviction counters for the solid block cache
+	 * @return The counters, and the current size and budget of the cache
+	 */
+	[[nodiscard]] DatCacheStats getSolidCacheStats() const {
+		return solidCache.getStats();
+	}
+
+	/**
+	 * Gets a file from the archive through the cache of decompressed files
+	 * Hits hand out the cached buffer itself rather than a copy, so the returned data must not be modified
+	 * @param File The path to the file in the archive
+	 * @return The file's data, or nullptr if it couldn't be read
+	 */
+	DatSharedBuffer getCachedFile(std::string_view File) const {
+		AssetHandle handle = resolve(File);
+		if (!isValid(handle)) {
+			std::cout << "Attempted to get file: " << File << ", but it doesn't exist" << std::endl;
+			return nullptr;
+		}
+
+		return getCachedFile(handle);
+	}
+
+	/**
+	 * Gets a file from the archive through the cache of decompressed files, using a handle from resolve
+	 * Hits hand out the cached buffer itself rather than a copy, so the returned data must not be modified
+	 * @param Handle The handle to the file, from this archive
+	 * @return The file's data, or nullptr if it couldn't be read
+	 */
+	DatSharedBuffer getCachedFile(AssetHandle Handle) const {
+		if (!isValid(Handle)) {
+			std::cout << "Attempted to get a file with an invalid handle" << std::endl;
+			return nullptr;
+		}
+
+		bool cacheEnabled = cache.isEnabled();
+		if (cacheEnabled) {
+			if (DatSharedBuffer cached = cache.find(Handle.index)) return cached;
+		}
+
+		// Miss, read it without holding up the cache, if another thread read it at the same time the first one in wins
+		DatFileEntry entry = entryAt(Handle.index);
+		auto data = std::make_shared<std::vector<char>>(entry.size());
+		if (!readFile(nameAt(Handle.index), entry, data->data())) return nullptr;
+
+		if (cacheEnabled) return cache.insert(Handle.index, std::move(data));
+		return data;
+	}
+
+private:
+	/**
+	 * Reads a file that has already been found in the table into a buffer
+	 * @param File The path to the file in the archive, used for reporting
+	 * @param entry The table entry for the file
+	 * @param buffer The buffer where the file data will end up (assumed to be the correct size already)
+	 * @return If the buffer was successfully filled
+	 */
+	bool readFile(std::string_view File, const DatFileEntry& entry, char* buffer) const {
+		if (entry.solidBlock != 0) {
+			DatSharedBuffer block = getSolidBlock(File, entry.solidBlock - 1);
+			return block && copySolidFile(File, entry, *block, buffer);
+		}
+
+		// Work out where the data is
+		int64_t dataSize = entry.dataEnd - entry.dataStart + 1;
+
+        char* destBuffer;
+
+        if (mappedFile.isOpen()) {
+            // Read straight out of the mapping, compressed data doesn't need a staging buffer
+            if (!mappedFile.containsRange(entry.dataStart, dataSize)) return false;
+            return decodeFile(File, entry, reinterpret_cast<const char*>(mappedFile.data()) + entry.dataStart, dataSize, buffer);
+        }
+
+        // Compressed data too big to stage is read and decompressed a window at a time
+        if (entry.flags.compressed && dataSize > STAGINGBUFFERLIMIT) {
+            return streamFile(File, entry, dataSize, buffer);
+        }
+
+        // Compressed data is staged in this thread's scratch buffer, so repeated reads don't allocate
+        std::vector<char> oversized;
+        if (entry.flags.compressed) {
+            destBuffer = stagingBuffer(dataSize, oversized);
+        } else {
+            destBuffer = buffer;
+        }
+
+		// Read the data, this doesn't move any shared position so other threads can read at the same time
+		if (!datFile.readAt(entry.dataStart, destBuffer, dataSize)) {
+            return false;
+        }
+
+		// Check the data and decompress it if needed
+		return decodeFile(File, entry, destBuffer, dataSize, buffer);
+	}
+
+	/**
+	 * Reads a compressed file without staging all of its stored data, checking and decompressing it STREAMWINDOW bytes at a time
+	 * Keeps the extra memory a read needs the same no matter how big the file is
+	 * @param File The path to the file in the archive, used for reporting
+	 * @param Entry The table entry for the file
+	 * @param StoredSize The amount of stored bytes
+	 * @param Buffer The buffer where the file data will end up (assumed to be the correct size already)
+	 * @return If the buffer was successfully filled
+	 */
+	bool streamFile(std::string_view File, const DatFileEntry& Entry, int64_t StoredSize, char* Buffer) const {
+		const DatCodec* codec = DatCodec::get(Entry.codec);
+		if (codec == nullptr) {
+			std::cout << "File: " << File << " is compressed with codec " << (int) Entry.codec << ", which this build doesn't support" << std::endl;
+			return false;
+		}
+
+		std::vector<char> oversized;
+		char* window = stagingBuffer(STREAMWINDOW, oversized);
+
+		bool verify = verifier.shouldVerify(Entry.tableIndex);
+		DatChecksum checksum(Entry.checksum);
+		int64_t position = 0;
+
+		// Reads the next piece of stored data, adding it to the checksum
+		auto next = [&](char* To, int64_t Length) {
+			if (Length > StoredSize - position || !datFile.readAt(Entry.dataStart + position, To, (size_t) Length)) return false;
+			if (verify) checksum.update(To, (size_t) Length);
+			position += Length;
+			return true;
+		};
+
+		bool decoded = false;
+		if (Entry.codec == DATCODECZLIB) {
+			z_stream* strm;
+			if (DatInflater::forThread().begin(strm) != Z_OK) return false;
+
+			unsigned char empty;
+			strm->avail_in = 0;
+			strm->avail_out = 0;
+			strm->next_out = Entry.dataSize != 0 ? reinterpret_cast<unsigned char*>(Buffer) : &empty;
+			int64_t outLeft = Entry.dataSize;
+
+			int rc = Z_OK;
+			while (rc == Z_OK) {
+				if (strm->avail_in == 0) {
+					int64_t length = std::min(StoredSize - position, STREAMWINDOW);
+					if (length == 0 || !next(window, length)) break;
+					strm->next_in = reinterpret_cast<unsigned char*>(window);
+					strm->avail_in = (uInt) length;
+				}
+				if (strm->avail_out == 0) {
+					strm->avail_out = (uInt) std::min(outLeft, ZLIBWINDOW);
+					outLeft -= strm->avail_out;
+				}
+
+				rc = inflate(strm, Z_NO_FLUSH);
+
+				// Data compressed against a dictionary stops straight after the header to ask for it
+				if (rc == Z_NEED_DICT && Entry.dictionary != 0 && Entry.dictionary <= dictionaries.size()) {
+					const auto& dictionary = dictionaries[Entry.dictionary - 1];
+					rc = inflateSetDictionary(strm, reinterpret_cast<const Bytef*>(dictionary.first), dictionary.second);
+				}
+			}
+
+			decoded = rc == Z_STREAM_END && outLeft == 0 && strm->avail_out == 0;
+		} else {
+			// Every chunk holds DATFILEBLOCKSIZE bytes of the file apart from the last
+			char* out = Buffer;
+			int64_t outLeft = Entry.dataSize;
+			std::vector<char> bigChunk;
+
+			decoded = true;
+			while (decoded && outLeft > 0) {
+				uint32_t chunkSize;
+				if (!next(reinterpret_cast<char*>(&chunkSize), 4)) {
+					decoded = false;
+					break;
+				}
+
+				bool stored = (chunkSize & DATFILECHUNKSTORED) != 0;
+				chunkSize &= ~DATFILECHUNKSTORED;
+				int64_t outChunk = std::min(outLeft, DATFILEBLOCKSIZE);
+
+				if (stored) {
+					decoded = chunkSize == outChunk && next(out, chunkSize);
+				} else {
+					char* in = window;
+					if (chunkSize > STREAMWINDOW) {
+						bigChunk.resize(chunkSize);
+						in = bigChunk.data();
+					}
+					decoded = next(in, chunkSize) && codec->decompress(in, chunkSize, out, (size_t) outChunk);
+				}
+
+				out += outChunk;
+				outLeft -= outChunk;
+			}
+
+			decoded = decoded && position == StoredSize;
+		}
+
+		if (!verify) return decoded;
+
+		// Corrupt data often fails to decompress part way through, finish the checksum so it can be reported as corrupt
+		while (!decoded && position < StoredSize) {
+			if (!next(window, std::min(StoredSize - position, STREAMWINDOW))) return false;
+		}
+		return matchChecksum(File, Entry, checksum.digest()) && decoded;
+	}
+
+	/**
+	 * Gets a decompressed solid block, from the solid block cache if it's there
+	 * @param File The path to a file in the block, used for reporting
+	 * @param Index The index of the block in the solid index
+	 * @return The block's data, or nullptr if it couldn't be read
+	 */
+	DatSharedBuffer getSolidBlock(std::string_view File, uint32_t Index) const {
+		if (Index >= solidCount) {
+			std::cout << "File: " << File << " is in a solid block that isn't in the archive" << std::endl;
+			return nullptr;
+		}
+
+		if (DatSharedBuffer cached = solidCache.find(Index)) return cached;
+
+		DatFileEntry blockEntry = solidAt(Index);
+		auto data = std::make_shared<std::vector<char>>(blockEntry.size());
+		if (!readFile(File, blockEntry, data->data())) return nullptr;
+
+		return solidCache.insert(Index, std::move(data));
+	}
+
+	/**
+	 * Copies a file out of its decompressed solid block, checking it against its checksum if the verify policy asks for it
+	 * @param File The path to the file in the archive, used for reporting
+	 * @param Entry The table entry for the file
+	 * @param Block The decompressed solid block holding the file
+	 * @param Buffer The buffer where the file data will end up (assumed to be the correct size already)
+	 * @return If the buffer was successfully filled
+	 */
+	bool copySolidFile(std::string_view File, const DatFileEntry& Entry, const std::vector<char>& Block, char* Buffer) const {
+		int64_t dataSize = Entry.dataEnd - Entry.dataStart + 1;
+		if (Entry.dataStart < 0 || dataSize != Entry.dataSize || dataSize < 0 || Entry.dataStart + dataSize > (int64_t) Block.size()) return false;
+
+		// Empty files have nothing to check or copy, and the buffer for them can be null
+		if (dataSize == 0) return true;
+
+		if (!checkChecksum(File, Entry, Block.data() + Entry.dataStart, dataSize)) return false;
+		memcpy(Buffer, Block.data() + Entry.dataStart, (size_t) dataSize);
+		return true;
+	}
+
+	/**
+	 * Reads part of a stored file with a block index, reading only the range plus whatever of its end blocks is needed to check them
+	 * @param File The path to the file in the archive, used for reporting
+	 * @param Entry The table entry for the file
+	 * @param Offset The offset in the file of the first byte to read
+	 * @param Length The amount of bytes to read, at least 1
+	 * @param Buffer The buffer where the bytes will end up (assumed to be big enough for Length bytes)
+	 * @return If the buffer was successfully filled
+	 */
+	bool readStoredRange(std::string_view File, const DatFileEntry& Entry, int64_t Offset, size_t Length, char* Buffer) const {
+		// Check the entry's blocks are all in the index, and cover the whole file
+		if ((uint64_t) Entry.firstBlock + Entry.blockCount > blockIndexCount) return false;
+		if ((uint64_t) ((Entry.dataSize + blockSize - 1) / blockSize) != Entry.blockCount) return false;
+		if (Entry.dataEnd - Entry.dataStart + 1 != Entry.dataSize) return false;
+
+		int64_t end = Offset + (int64_t) Length;
+		uint32_t first = (uint32_t) (Offset / blockSize);
+		uint32_t last = (uint32_t) ((end - 1) / blockSize);
+		uint64_t firstSlot = (uint64_t) entryCount + solidCount + Entry.firstBlock;
+
+		// Blocks the range only covers part of are read whole if they're going to be checked
+		bool checkFirst = verifier.shouldVerify(firstSlot + first);
+		bool checkLast = first == last ? checkFirst : verifier.shouldVerify(firstSlot + last);
+		int64_t headStart = checkFirst ? (int64_t) first * blockSize : Offset;
+		int64_t tailEnd = checkLast ? std::min((int64_t) (last + 1) * blockSize, Entry.dataSize) : end;
+
+		std::vector<char> head((size_t) (Offset - headStart));
+		std::vector<char> tail((size_t) (tailEnd - end));
+		if (!head.empty() && !readRaw(Entry.dataStart + headStart, head.data(), head.size())) return false;
+		if (!readRaw(Entry.dataStart + Offset, Buffer, Length)) return false;
+		if (!tail.empty() && !readRaw(Entry.dataStart + end, tail.data(), tail.size())) return false;
+
+		// Takes the crc of part of the file, which can be spread across the head, the buffer, and the tail
+		auto crcOf = [&](int64_t From, int64_t To) {
+			uint32_t crc = 0;
+			if (From < Offset) crc = DatCrc32::compute(crc, head.data() + (From - headStart), (size_t) (Offset - From));
+			int64_t from = std::max(From, Offset);
+			int64_t to = std::min(To, end);
+			if (from < to) crc = DatCrc32::compute(crc, Buffer + (from - Offset), (size_t) (to - from));
+			if (To > end) crc = DatCrc32::compute(crc, tail.data() + (std::max(From, end) - end), (size_t) (To - std::max(From, end)));
+			return crc;
+		};
+
+		for (uint32_t i = first; i <= last; ++i) {
+			uint64_t slot = firstSlot + i;
+			bool check = i == first ? checkFirst : i == last ? checkLast : verifier.shouldVerify(slot);
+			if (!check) continue;
+
+			DatBlock block = blockAt((uint64_t) Entry.firstBlock + i);
+			int64_t blockStart = (int64_t) i * blockSize;
+			uint32_t generatedCrc = crcOf(blockStart, std::min(blockStart + blockSize, Entry.dataSize));
+			if (block.crc != generatedCrc) {
+				reportIntegrityError(File, i, DATCHECKSUMCRC32, block.crc, generatedCrc);
+				return false;
+			}
+			verifier.markVerified(slot);
+		}
+
+		return true;
+	}
+
+	/**
+	 * Reads part of a file that has already been found in the table into a buffer
+	 * Compressed files with a block index only read and inflate the blocks the range touches, checking each block's crc if the verify policy asks for it
+	 * Stored files with a block index read just the range, checking the blocks it touches, and stored files without one only read the range when they aren't being checked
+	 * Anything else, including entries using codecs other than ZLib, is read whole and the range copied out of it
+	 * @param File The path to the file in the archive, used for reporting
+	 * @param Entry The table entry for the file
+	 * @param Offset The offset in the uncompressed file of the first byte to read
+	 * @param Length The amount of bytes to read
+	 * @param Buffer The buffer where the bytes will end up (assumed to be big enough for Length bytes)
+	 * @return If the buffer was successfully filled
+	 */
+	bool readFileRange(std::string_view File, const DatFileEntry& Entry, int64_t Offset, size_t Length, char* Buffer) const {
+		if (Offset < 0 || Offset > Entry.dataSize || (uint64_t) Length > (uint64_t) (Entry.dataSize - Offset)) {
+			std::cout << "Attempted to read past the end of file: " << File << std::endl;
+			return false;
+		}
+		if (Length == 0) return true;
+
+		if (!Entry.flags.compressed && Entry.solidBlock == 0) {
+			if (Entry.blockCount != 0) return readStoredRange(File, Entry, Offset, Length, Buffer);
+
+			// The only checksum covers the whole file, so it's only read whole if it's going to be checked
+			int64_t dataSize = Entry.dataEnd - Entry.dataStart + 1;
+			if (dataSize != Entry.dataSize) return false;
+			if (!verifier.shouldVerify(Entry.tableIndex)) return readRaw(Entry.dataStart + Offset, Buffer, Length);
+
+			std::vector<char> whole((size_t) dataSize);
+			if (!readRaw(Entry.dataStart, whole.data(), whole.size())) return false;
+			if (!matchChecksum(File, Entry, DatChecksum::compute(Entry.checksum, whole.data(), whole.size()))) return false;
+
+			memcpy(Buffer, whole.data() + Offset, Length);
+			return true;
+		}
+
+		if (!Entry.flags.compressed || Entry.codec != DATCODECZLIB || Entry.blockCount == 0) {
+			std::vector<char> whole(Entry.size());
+			if (!readFile(File, Entry, whole.data())) return false;
+
+			memcpy(Buffer, whole.data() + Offset, Length);
+			return true;
+		}
+
+		// Check the entry's blocks are all in the index, and cover the whole file
+		if ((uint64_t) Entry.firstBlock + Entry.blockCount > blockIndexCount) return false;
+		if ((uint64_t) ((Entry.dataSize + blockSize - 1) / blockSize) != Entry.blockCount) return false;
+
+		int64_t storedSize = Entry.dataEnd - Entry.dataStart + 1;
+		uint32_t first = (uint32_t) (Offset / blockSize);
+		uint32_t last = (uint32_t) ((Offset + (int64_t) Length - 1) / blockSize);
+
+		// Each block runs up to the next one, the last runs up to the adler32 trailer
+		auto blockEnd = [&](uint32_t Block) {
+			return Block + 1 < Entry.blockCount ? blockAt((uint64_t) Entry.firstBlock + Block + 1).offset : storedSize - 4;
+		};
+
+		// The blocks are next to each other, so get all of them with one read
+		int64_t readStart = blockAt((uint64_t) Entry.firstBlock + first).offset;
+		int64_t readEnd = blockEnd(last);
+		if (readStart < 2 || readEnd < readStart || readEnd > storedSize - 4) return false;
+
+		const char* stored;
+		std::vector<char> oversized;
+		if (mappedFile.isOpen()) {
+			if (!mappedFile.containsRange(Entry.dataStart + readStart, readEnd - readStart)) return false;
+			stored = reinterpret_cast<const char*>(mappedFile.data()) + Entry.dataStart + readStart;
+		} else {
+			char* staging = stagingBuffer(readEnd - readStart, oversized);
+			if (!datFile.readAt(Entry.dataStart + readStart, staging, (size_t) (readEnd - readStart))) return false;
+			stored = staging;
+		}
+
+		std::vector<char> partial;
+		for (uint32_t i = first; i <= last; ++i) {
+			DatBlock block = blockAt((uint64_t) Entry.firstBlock + i);
+			int64_t end = blockEnd(i);
+			if (block.offset < readStart || end < block.offset) return false;
+
+			const char* data = stored + (block.offset - readStart);
+			size_t dataSize = (size_t) (end - block.offset);
+
+			uint64_t slot = (uint64_t) entryCount + solidCount + Entry.firstBlock + i;
+			if (verifier.shouldVerify(slot)) {
+				uint32_t generatedCrc = DatCrc32::compute(0, data, dataSize);
+				if (block.crc != generatedCrc) {
+					reportIntegrityError(File, i, DATCHECKSUMCRC32, block.crc, generatedCrc);
+					return false;
+				}
+				verifier.markVerified(slot);
+			}
+
+			// Inflate straight into the buffer, unless the range starts part way into the block
+			int64_t blockStart = (int64_t) i * blockSize;
+			int64_t from = std::max(Offset, blockStart) - blockStart;
+			int64_t to = std::min(Offset + (int64_t) Length, blockStart + blockSize) - blockStart;
+
+			if (from == 0) {
+				if (inflateBlock(data, dataSize, Buffer + (blockStart - Offset), (size_t) to) != Z_OK) return false;
+			} else {
+				partial.resize((size_t) to);
+				if (inflateBlock(data, dataSize, partial.data(), (size_t) to) != Z_OK) return false;
+				memcpy(Buffer, partial.data() + from, (size_t) (to - from));
+			}
+		}
+
+		return true;
+	}
+
+public:
+	/**
+	 * Reads part of a file from the archive
+	 * Files written as seekable, and big files, only have the blocks the range touches read, inflated and checked
+	 * @param File The path to the file in the archive
+	 * @param Offset The offset in the file of the first byte to read
+	 * @param Length The amount of bytes to read
+	 * @param Buffer The buffer where the bytes will end up (assumed to be big enough for Length bytes)
+	 * @return If the buffer was successfully filled
+	 */
+	bool readRange(std::string_view File, int64_t Offset, size_t Length, char* Buffer) const {
+		DatFileEntry entry;
+		if (!findEntry(File, entry)) {
+			std::cout << "Attempted to get file: " << File << ", but it doesn't exist" << std::endl;
+			return false;
+		}
+
+		return readFileRange(File, entry, Offset, Length, Buffer);
+	}
+
+	/**
+	 * Reads part of a file from the archive, using a handle from resolve
+	 * @param Handle The handle to the file, from this archive
+	 * @param Offset The offset in the file of the first byte to read
+	 * @param Length The amount of bytes to read
+	 * @param Buffer The buffer where the bytes will end up (assumed to be big enough for Length bytes)
+	 * @return If the buffer was successfully filled
+	 */
+	bool readRange(AssetHandle Handle, int64_t Offset, size_t Length, char* Buffer) const {
+		if (!isValid(Handle)) {
+			std::cout << "Attempted to get a file with an invalid handle" << std::endl;
+			return false;
+		}
+
+		return readFileRange(nameAt(Handle.index), entryAt(Handle.index), Offset, Length, Buffer);
+	}
+
+	/**
+	 * Opens a file for reading a window at a time, so it can be fed to a decoder without holding all of it in memory
+	 * The reader is a std::streambuf, it can be read through a std::istream or with its own read and readChunk
+	 * If the file is checked, a mismatch is only found once the whole file has been read, so check failed on the reader at the end
+	 * @param File The path to the file in the archive
+	 * @return A reader for the file, which is false if the file couldn't be opened
+	 */
+	DatEntryReader openStream(std::string_view File) const {
+		DatFileEntry entry;
+		if (!findEntry(File, entry)) {
+			std::cout << "Attempted to get file: " << File << ", but it doesn't exist" << std::endl;
+			return {};
+		}
+
+		return openEntryStream(File, entry);
+	}
+
+	/**
+	 * Opens a file for reading a window at a time, using a handle from resolve
+	 * @param Handle The handle to the file, from this archive
+	 * @return A reader for the file, which is false if the file couldn't be opened
+	 */
+	DatEntryReader openStream(AssetHandle Handle) const {
+		if (!isValid(Handle)) {
+			std::cout << "Attempted to get a file with an invalid handle" << std::endl;
+			return {};
+		}
+
+		return openEntryStream(nameAt(Handle.index), entryAt(Handle.index));
+	}
+
+private:
+	/**
+	 * Makes a reader for a file that has already been found in the table
+	 * @param File The path to the file in the archive, used for reporting
+	 * @param Entry The table entry for the file
+	 * @return A reader for the file, which is false if the file couldn't be opened
+	 */
+	DatEntryReader openEntryStream(std::string_view File, const DatFileEntry& Entry) const {
+		// Files in solid blocks are handed out of the decompressed block, so they can be checked up front
+		if (Entry.solidBlock != 0) {
+			DatSharedBuffer block = getSolidBlock(File, Entry.solidBlock - 1);
+			int64_t dataSize = Entry.dataEnd - Entry.dataStart + 1;
+			if (!block || Entry.dataStart < 0 || dataSize != Entry.dataSize || dataSize < 0 || Entry.dataStart + dataSize > (int64_t) block->size()) return {};
+			if (!checkChecksum(File, Entry, block->data() + Entry.dataStart, dataSize)) return {};
+			return DatEntryReader(Entry, std::move(block));
+		}
+
+		const char* dictionary = nullptr;
+		uint32_t dictionarySize = 0;
+		if (Entry.flags.compressed) {
+			if (DatCodec::get(Entry.codec) == nullptr) {
+				std::cout << "File: " << File << " is compressed with codec " << (int) Entry.codec << ", which this build doesn't support" << std::endl;
+				return {};
+			}
+
+			if (Entry.codec == DATCODECZLIB && Entry.dictionary != 0) {
+				if (Entry.dictionary > dictionaries.size()) {
+					std::cout << "File: " << File << " was compressed against a dictionary that isn't in the archive" << std::endl;
+					return {};
+				}
+				dictionary = dictionaries[Entry.dictionary - 1].first;
+				dictionarySize = dictionaries[Entry.dictionary - 1].second;
+			}
+		}
+
+		// Whether to check the file is decided now, the checksum is compared once the reader gets to the end
+		DatEntryReader::VerifyFunction verify;
+		if (verifier.shouldVerify(Entry.tableIndex)) {
+			verify = [this, Entry, name = std::string(File)](uint64_t Generated) {
+				return matchChecksum(name, Entry, Generated);
+			};
+		}
+
+		return DatEntryReader(Entry, [this](int64_t Offset, char* Buffer, size_t Length) {
+			return readRaw(Offset, Buffer, Length);
+		}, std::move(verify), dictionary, dictionarySize);
+	}
+
+public:
+	/**
+	 * Gets a file from the archive without blocking the calling thread
+	 * On Linux the read is handed to io_uring, so a single I/O thread keeps many reads in flight, and the file is checked and decompressed on the pool once it arrives
+	 * Anywhere else, for memory mapped archives, and for files in solid blocks or too big to stage, the whole read runs on the pool instead
+	 * The archive must not be reopened or destroyed while it has reads in flight
+	 * @param File The path to the file in the archive
+	 * @param Pool The thread pool to check and decompress the file on
+	 * @return A future for the file's data, which is empty if the file couldn't be read
+	 */
+	std::future<std::vector<char>> getFileAsync(std::string_view File, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+		auto promise = std::make_shared<std::promise<std::vector<char>>>();
+		std::future<std::vector<char>> future = promise->get_future();
+		getFileAsync(File, [promise](std::vector<char>&& Data) {
+			promise->set_value(std::move(Data));
+		}, Pool);
+		return future;
+	}
+
+	/**
+	 * Gets a file from the archive without blocking the calling thread, using a handle from resolve
+	 * @param Handle The handle to the file, from this archive
+	 * @param Pool The thread pool to check and decompress the file on
+	 * @return A future for the file's data, which is empty if the file couldn't be read
+	 */
+	std::future<std::vector<char>> getFileAsync(AssetHandle Handle, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+		auto promise = std::make_shared<std::promise<std::vector<char>>>();
+		std::future<std::vector<char>> future = promise->get_future();
+		getFileAsync(Handle, [promise](std::vector<char>&& Data) {
+			promise->set_value(std::move(Data));
+		}, Pool);
+		return future;
+	}
+
+	/**
+	 * Gets a file from the archive without blocking the calling thread, handing it to a callback once it is ready
+	 * @param File The path to the file in the archive
+	 * @param Callback Called with the file's data, which is empty if the file couldn't be read, from the pool's threads or straight away if the file doesn't exist
+	 * @param Pool The thread pool to check and decompress the file on
+	 */
+	void getFileAsync(std::string_view File, std::function<void(std::vector<char>&&)> Callback, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+		DatFileEntry entry;
+		if (!findEntry(File, entry)) {
+			std::cout << "Attempted to get file: " << File << ", but it doesn't exist" << std::endl;
+			Callback({});
+			return;
+		}
+
+		readFileAsync(std::string(File), entry, std::move(Callback), Pool);
+	}
+
+	/**
+	 * Gets a file from the archive without blocking the calling thread, handing it to a callback once it is ready, using a handle from resolve
+	 * @param Handle The handle to the file, from this archive
+	 * @param Callback Called with the file's data, which is empty if the file couldn't be read, from the pool's threads or straight away if the handle is invalid
+	 * @param Pool The thread pool to check and decompress the file on
+	 */
+	void getFileAsync(AssetHandle Handle, std::function<void(std::vector<char>&&)> Callback, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+		if (!isValid(Handle)) {
+			std::cout << "Attempted to get a file with an invalid handle" << std::endl;
+			Callback({});
+			return;
+		}
+
+		readFileAsync(std::string(nameAt(Handle.index)), entryAt(Handle.index), std::move(Callback), Pool);
+	}
+
+#ifdef DATARCHIVE_HAS_COROUTINES
+	/**
+	 * Reads a file from the archive in a coroutine, co_await suspends it until the file has been read, checked and decompressed
+	 * The read is the same as getFileAsync's, and starts once the awaitable is awaited
+	 * @param File The path to the file in the archive
+	 * @param Executor Where to resume the coroutine, empty to resume it on the pool thread that finished the read
+	 * @param Pool The thread pool to check and decompress the file on
+	 * @return An awaitable giving the file's data, which is empty if the file couldn't be read
+	 */
+	DatReadAwaitable<std::vector<char>> read(std::string_view File, DatExecutor Executor = {}, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+		return DatReadAwaitable<std::vector<char>>([this, file = std::string(File), &Pool](std::function<void(std::vector<char>&&)> Done) {
+			getFileAsync(file, std::move(Done), Pool);
+		}, std::move(Executor));
+	}
+
+	/**
+	 * Reads a file from the archive in a coroutine, using a handle from resolve
+	 * @param Handle The handle to the file, from this archive
+	 * @param Executor Where to resume the coroutine, empty to resume it on the pool thread that finished the read
+	 * @param Pool The thread pool to check and decompress the file on
+	 * @return An awaitable giving the file's data, which is empty if the file couldn't be read
+	 */
+	DatReadAwaitable<std::vector<char>> read(AssetHandle Handle, DatExecutor Executor = {}, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+		return DatReadAwaitable<std::vector<char>>([this, Handle, &Pool](std::function<void(std::vector<char>&&)> Done) {
+			getFileAsync(Handle, std::move(Done), Pool);
+		}, std::move(Executor));
+	}
+
+	/**
+	 * Reads a batch of files from the archive in a coroutine, resuming it once they have all been read
+	 * The files are read like getFiles, in the order they are stored in the archive rather than one request each
+	 * @param Files The paths to the files in the archive
+	 * @param Executor Where to resume the coroutine, empty to resume it on the pool thread that finished the batch
+	 * @param Pool The thread pool to read, check and decompress the files on
+	 * @return An awaitable giving the data for each file, in the same order as Files, files that couldn't be read are left empty
+	 */
+	DatReadAwaitable<std::vector<std::vector<char>>> readAll(std::vector<std::string> Files, DatExecutor Executor = {}, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+		return DatReadAwaitable<std::vector<std::vector<char>>>([this, files = std::move(Files), &Pool](std::function<void(std::vector<std::vector<char>>&&)> Done) {
+			// getFiles blocks until the batch is done, so it runs on the pool, where it helps with its own work while it waits
+			Pool.submit([this, files, &Pool, Done = std::move(Done)]() {
+				Done(getFiles(files, Pool));
+			});
+		}, std::move(Executor));
+	}
+#endif
+
+private:
+	/**
+	 * Gets the ring for async reads, setting it up the first time
+	 * @return The ring, or nullptr if reads can't be handed to the kernel
+	 */
+	DatAsyncIo* asyncReader() const {
+		if (mappedFile.isOpen()) return nullptr;
+
+		std::lock_guard<std::mutex> lock(asyncMutex);
+		if (!asyncTried) {
+			asyncTried = true;
+			asyncIo = DatAsyncIo::create(datFile);
+		}
+		return asyncIo.get();
+	}
+
+	/**
+	 * Reads a file that has already been found in the table without blocking the calling thread
+	 * @param File The path to the file in the archive, used for reporting
+	 * @param Entry The table entry for the file
+	 * @param Callback Called from the pool with the file's data, which is empty if the file couldn't be read
+	 * @param Pool The thread pool to check and decompress the file on
+	 */
+	void readFileAsync(std::string File, const DatFileEntry& Entry, std::function<void(std::vector<char>&&)> Callback, DatThreadPool& Pool) const {
+		struct AsyncRead {
+			std::string file;
+			DatFileEntry entry;
+			std::vector<char> stored;
+			std::vector<char> data;
+			std::function<void(std::vector<char>&&)> callback;
+		};
+
+		auto pending = std::make_shared<AsyncRead>();
+		pending->file = std::move(File);
+		pending->entry = Entry;
+		pending->callback = std::move(Callback);
+
+		int64_t dataSize = Entry.dataEnd - Entry.dataStart + 1;
+		bool direct = Entry.solidBlock == 0 && dataSize >= 0 && !(Entry.flags.compressed && dataSize > STAGINGBUFFERLIMIT);
+		DatAsyncIo* io = direct ? asyncReader() : nullptr;
+
+		if (io == nullptr) {
+			Pool.submit([this, pending]() {
+				pending->data.resize(pending->entry.size());
+				if (!readFile(pending->file, pending->entry, pending->data.data())) pending->data = {};
+				pending->callback(std::move(pending->data));
+			});
+			return;
+		}
+
+		// Compressed data is read into its own buffer, stored data straight into the file's
+		pending->data.resize(Entry.size());
+		if (Entry.flags.compressed) pending->stored.resize((size_t) dataSize);
+		char* target = Entry.flags.compressed ? pending->stored.data() : pending->data.data();
+
+		// The I/O thread only hands the read to the pool, which checks and decompresses it
+		io->read(Entry.dataStart, target, (size_t) dataSize, [this, pending, target, dataSize, &Pool](bool Success) {
+			Pool.submit([this, pending, target, dataSize, Success]() {
+				if (!Success || !decodeFile(pending->file, pending->entry, target, dataSize, pending->data.data())) pending->data = {};
+				pending->callback(std::move(pending->data));
+			});
+		});
+	}
+
+public:
+    /**
+     * Gets a batch of files from the archive
+     * The data is read in the order it is stored in the archive, and checked and decompressed on the thread pool as each read finishes
+     * @param Files The paths to the files in the archive
+     * @param Pool The thread pool to check and decompress the files on
+     * @return The data for each file, in the same order as Files, files that couldn't be read are left empty
+     */
+    std::vector<std::vector<char>> getFiles(const std::vector<std::string>& Files, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+        std::vector<std::vector<char>> results(Files.size());
+        getFiles(Files, [&results](size_t Index, std::vector<char>&& Data) {
+            results[Index] = std::move(Data);
+        }, Pool);
+        return results;
+    }
+
+    /**
+     * Gets a batch of files from the archive, handing each one to a callback as soon as it is ready
+     * The data is read in the order it is stored in the archive, and checked and decompressed on the thread pool as each read finishes
+     * Files stored close together are read with a single request, setCoalesceGap sets how far apart they can be
+     * The callback is called from the pool's threads and the calling thread, possibly at the same time, this returns once every callback has returned
+     * @param Files The paths to the files in the archive
+     * @param Callback Called with the index of the file in Files and its data, for every file that was successfully read
+     * @param Pool The thread pool to check and decompress the files on
+     * @return Whether every file was successfully read
+     */
+    bool getFiles(const std::vector<std::string>& Files, const std::function<void(size_t, std::vector<char>&&)>& Callback, DatThreadPool& Pool = DatThreadPool::getDefault()) const {
+        struct Request {
+            size_t index;
+            DatFileEntry entry;
+        };
+
+        bool success = true;
+
+        // Find all the entries, files in solid blocks are gathered separately
+        std::vector<Request> requests;
+        std::vector<Request> solidRequests;
+        requests.reserve(Files.size());
+        for (size_t i = 0; i < Files.size(); ++i) {
+            DatFileEntry entry;
+            if (!findEntry(Files[i], entry)) {
+                std::cout << "Attempted to get file: " << Files[i] << ", but it doesn't exist" << std::endl;
+                success = false;
+                continue;
+            }
+
+            if (entry.solidBlock != 0) solidRequests.push_back({i, entry});
+            else requests.push_back({i, entry});
+        }
+
+        // Read in the order the data is stored so the disk sees one forward sweep
+        std::sort(requests.begin(), requests.end(), [](const Request& A, const Request& B) {
+            return A.entry.dataStart < B.entry.dataStart;
+        });
+
+        std::atomic<bool> decodeFailed{false};
+        DatTaskCounter counter;
+
+        // Checks and decompresses a file on the pool, reading it there instead if it's mapped or streamed
+        auto decode = [&](const Request& Item, int64_t DataSize, bool Streamed, std::vector<char>&& Stored) {
+            counter.add();
+            Pool.submit([this, &Files, &Callback, &counter, &decodeFailed, entry = Item.entry, dataSize = DataSize, streamed = Streamed, index = Item.index, stored = std::move(Stored)]() mutable {
+                std::vector<char> data;
+                bool decoded;
+
+                if (streamed) {
+                    data.resize(entry.size());
+                    decoded = streamFile(Files[index], entry, dataSize, data.data());
+                } else if (mappedFile.isOpen()) {
+                    data.resize(entry.size());
+                    decoded = decodeFile(Files[index], entry, reinterpret_cast<const char*>(mappedFile.data()) + entry.dataStart, dataSize, data.data());
+                } else if (entry.flags.compressed) {
+                    data.resize(entry.size());
+                    decoded = decodeFile(Files[index], entry, stored.data(), dataSize, data.data());
+                } else {
+                    // Stored data is already the file, just check it
+                    decoded = decodeFile(Files[index], entry, stored.data(), dataSize, stored.data());
+                    data = std::move(stored);
+                }
+
+                if (decoded) Callback(index, std::move(data));
+                else decodeFailed = true;
+
+                counter.done();
+            });
+        };
+
+        // Compressed files too big to stage are read by the tasks themselves
+        auto isStreamed = [this](const DatFileEntry& Entry, int64_t DataSize) {
+            return !mappedFile.isOpen() && Entry.flags.compressed && DataSize > STAGINGBUFFERLIMIT;
+        };
+
+        for (size_t first = 0; first < requests.size();) {
+            const DatFileEntry& entry = requests[first].entry;
+            int64_t dataSize = entry.dataEnd - entry.dataStart + 1;
+
+            if (dataSize < 0 || (mappedFile.isOpen() && !mappedFile.containsRange(entry.dataStart, dataSize))) {
+                success = false;
+                ++first;
+                continue;
+            }
+
+            // Mapped archives are read by the tasks themselves, as are streamed files
+            bool streamed = isStreamed(entry, dataSize);
+            if (mappedFile.isOpen() || streamed) {
+                decode(requests[first], dataSize, streamed, {});
+                ++first;
+                continue;
+            }
+
+            // Files stored close enough together are read with one request, skipping the gaps between them
+            size_t last = first + 1;
+            int64_t runEnd = entry.dataEnd;
+            while (last < requests.size()) {
+                const DatFileEntry& next = requests[last].entry;
+                int64_t nextSize = next.dataEnd - next.dataStart + 1;
+                if (nextSize < 0 || isStreamed(next, nextSize)) break;
+                if (next.dataStart <= runEnd || next.dataStart - runEnd - 1 > coalesceGap || next.dataEnd - entry.dataStart + 1 > COALESCELIMIT) break;
+
+                runEnd = next.dataEnd;
+                ++last;
+            }
+
+            std::vector<std::vector<char>> stored(last - first);
+            std::vector<DatReadSlice> slices;
+            slices.reserve((last - first) * 2);
+            for (size_t i = first; i < last; ++i) {
+                const DatFileEntry& current = requests[i].entry;
+                if (i > first) {
+                    int64_t gap = current.dataStart - requests[i - 1].entry.dataEnd - 1;
+                    if (gap > 0) slices.push_back({nullptr, (size_t) gap});
+                }
+
+                stored[i - first].resize((size_t) (current.dataEnd - current.dataStart + 1));
+                slices.push_back({stored[i - first].data(), stored[i - first].size()});
+            }
+
+            if (!datFile.readVectorAt(entry.dataStart, slices.data(), slices.size())) {
+                success = false;
+            } else {
+                for (size_t i = first; i < last; ++i) {
+                    decode(requests[i], (int64_t) stored[i - first].size(), false, std::move(stored[i - first]));
+                }
+            }
+            first = last;
+        }
+
+        // Each solid block is decompressed once, by a task that hands out every requested file in it
+        std::stable_sort(solidRequests.begin(), solidRequests.end(), [](const Request& A, const Request& B) {
+            return A.entry.solidBlock < B.entry.solidBlock;
+        });
+
+        for (size_t first = 0; first < solidRequests.size();) {
+            size_t last = first;
+            while (last < solidRequests.size() && solidRequests[last].entry.solidBlock == solidRequests[first].entry.solidBlock) ++last;
+
+            counter.add();
+            Pool.submit([this, &Files, &Callback, &counter, &decodeFailed, &solidRequests, first, last]() {
+                const Request& head = solidRequests[first];
+                DatSharedBuffer block = getSolidBlock(Files[head.index], head.entry.solidBlock - 1);
+
+                for (size_t i = first; i < last; ++i) {
+                    const Request& request = solidRequests[i];
+                    std::vector<char> data(request.entry.size());
+
+                    if (block && copySolidFile(Files[request.index], request.entry, *block, data.data())) Callback(request.index, std::move(data));
+                    else decodeFailed = true;
+                }
+
+                counter.done();
+            });
+            first = last;
+        }
+
+        Pool.wait(counter);
+        return success && !decodeFailed;
+    }
+
+    /**
+     * Gets a view of a file straight out of the memory mapped archive, without copying it
+     * The view is only valid while the archive stays open, and is only available for files that aren't compressed
+     * @param File The path to the file in the archive
+     * @return A view of the file's bytes, or an empty view if the archive isn't mapped, the file doesn't exist, or the file is compressed
+     */
+    DatByteView getFileView(std::string_view File) const {
+        if (!mappedFile.isOpen()) {
+            std::cout << "Attempted to get a view of file: " << File << ", but the archive isn't memory mapped" << std::endl;
+            return {};
+        }
+
+        DatFileEntry entry;
+        if (!findEntry(File, entry)) {
+            std::cout << "Attempted to get file: " << File << ", but it doesn't exist" << std::endl;
+            return {};
+        }
+
+        if (entry.flags.compressed) {
+            std::cout << "Attempted to get a view of file: " << File << ", but it is compressed" << std::endl;
+            return {};
+        }
+
+        int64_t dataSize = entry.dataEnd - entry.dataStart + 1;
+        if (!mappedFile.containsRange(entry.dataStart, dataSize)) return {};
+
+        const std::byte* mappedData = mappedFile.data() + entry.dataStart;
+        if (!checkChecksum(File, entry, reinterpret_cast<const char*>(mappedData), dataSize)) return {};
+
+        return {mappedData, (size_t) dataSize};
+    }
+
+    /**
+     * Gets the header for the file at the address
+     * @param filePath The path to the file in the archive
+     * @return The table entry for the file, or an empty entry if the file doesn't exist
+     */
+    [[nodiscard]] DatFileEntry getFileHeader(std::string_view filePath) const {
+        DatFileEntry entry;
+        findEntry(filePath, entry);
+        return entry;
+    }
+
+    /**
+     * Gets the header for a file, using a handle from resolve
+     * @param Handle The handle to the file, from this archive
+     * @return The table entry for the file, or an empty entry if the handle is invalid
      */
-    [[nodiscard]] const DatFileEntry& getFileHeader(const std::string& filePath) {
-        return fileTable[filePath];
+    [[nodiscard]] DatFileEntry getFileHeader(AssetHandle Handle) const {
+        if (!isValid(Handle)) return {};
+        return entryAt(Handle.index);
     }
 
     /**
@@ -224,8 +1895,9 @@ public:
      * @param filePath The path to the file to check in the archive
      * @return If the archive file contains a file at the filePath
      */
-    [[nodiscard]] bool contains(const std::string& filePath) const {
-        return fileTable.count(filePath) != 0;
+    [[nodiscard]] bool contains(std::string_view filePath) const {
+        DatFileEntry entry;
+        return findEntry(filePath, entry);
     }
 
     /**
@@ -233,20 +1905,21 @@ public:
      * @return The amount of files stored inside the archive file
      */
     [[nodiscard]] size_t size() const {
-        return fileTable.size();
+        return entryCount;
     }
 
 	/**
 	 * Returns a list of all the files inside the archive file
 	 * @return A vector containing all of the files in the archive
 	 */
-	std::vector<std::string> getListOfFiles() {
-		// Create the list to return, set it to the right size so we don't have to keep moving it as we add items
-		std::vector<std::string> keys(fileTable.size());
+	[[nodiscard]] std::vector<std::string> getListOfFiles() const {
+		// Create the list to return, reserve the right size so we don't have to keep moving it as we add items
+		std::vector<std::string> keys;
+		keys.reserve(entryCount);
 
-		// Add all the keys
-		for (auto& key : fileTable) {
-			keys.push_back(key.first);
+		// Add all the names, in the order they are in the table
+		for (uint32_t i = 0; i < entryCount; ++i) {
+			keys.emplace_back(nameAt(i));
 		}
 
 		return keys;
@@ -1,7 +1,12 @@
 #pragma once
+
+#include <DatArchive/DatChecksum.h>
+
 #include <algorithm>
 #include <unordered_map>
 #include <bitset>
+#include <cstddef>
+#include <cstring>
 #include <filesystem>
 #include <zlib.h>
 #include <cstdint>
@@ -10,11 +15,39 @@
 #include <fstream>
 #include <utility>
 #include <cassert>
+#include <vector>
 
 #define CHUNK 16384
 
 static const char DATFILESIGNATURE[4] = {'\xB1', '\x44', '\x41', '\x54'};
-static const uint8_t DATFILEVERSION = 0x02;
+static const uint8_t DATFILEVERSION = 0x09;
+static const uint8_t DATFILEMINVERSION = 0x02;
+
+// Sizes of the parts of the version 3 and later table, see File Spec.txt
+static const size_t DATFILETABLEHEADERSIZE = 16;
+static const size_t DATFILERECORDSIZE = 56;
+static const size_t DATFILEHASHHEADERSIZE = 8;
+static const size_t DATFILEBLOCKHEADERSIZE = 16;
+static const size_t DATFILEBLOCKENTRYSIZE = 16;
+static const size_t DATFILEDICTIONARYHEADERSIZE = 8;
+static const size_t DATFILEDICTIONARYENTRYSIZE = 8;
+static const size_t DATFILESOLIDHEADERSIZE = 8;
+static const size_t DATFILESOLIDENTRYSIZE = 32;
+
+// The amount of uncompressed bytes in each block of an entry that has a block index, and in each chunk of an entry not compressed with ZLib
+static const int64_t DATFILEBLOCKSIZE = 1024 * 1024;
+
+// Set in a chunk's size when the chunk is stored as it is, because compressing it made it bigger
+static const uint32_t DATFILECHUNKSTORED = 0x80000000u;
+
+/**
+ * Gets the size of the table records written for a version
+ * @param Version The format version
+ * @return The size of each record in bytes
+ */
+inline size_t getRecordSize(uint8_t Version) {
+	return Version >= 0x09 ? DATFILERECORDSIZE : Version >= 0x05 ? 48 : 40;
+}
 
 /**
  * @file
@@ -45,14 +78,66 @@ bool createFile(std::ofstream& File, const std::string& Path, bool Force = false
 	return true;
 }
 
+/**
+ * A read only view over a contiguous run of bytes owned by something else
+ * Stands in for std::span<const std::byte> while the library targets C++17
+ */
+struct DatByteView {
+	const std::byte* ptr = nullptr;
+	size_t length = 0;
+
+	DatByteView() = default;
+	DatByteView(const std::byte* Ptr, size_t Length) : ptr(Ptr), length(Length) {}
+
+	[[nodiscard]] const std::byte* data() const { return ptr; }
+	[[nodiscard]] size_t size() const { return length; }
+	[[nodiscard]] bool empty() const { return length == 0; }
+	[[nodiscard]] const std::byte* begin() const { return ptr; }
+	[[nodiscard]] const std::byte* end() const { return ptr + length; }
+	const std::byte& operator[](size_t Index) const { return ptr[Index]; }
+};
+
+/**
+ * A file resolved from a path once, used to fetch it from the same archive without looking the path up again
+ * Handles are the index of the file's record, so they stay valid for as long as the archive is open
+ */
+struct AssetHandle {
+	static const uint32_t INVALID = UINT32_MAX;
+
+	uint32_t index = INVALID;
+
+	[[nodiscard]] bool operator==(const AssetHandle& Other) const { return index == Other.index; }
+	[[nodiscard]] bool operator!=(const AssetHandle& Other) const { return index != Other.index; }
+};
+
+/**
+ * Where a block of an entry starts, and the crc of its stored bytes
+ */
+struct DatBlock {
+	int64_t offset = 0;
+	uint32_t crc = 0;
+};
+
 struct FileDescriptor {
     bool compressed;
     bool encrypted;
     std::string destDirectory;
 
-    FileDescriptor(bool compressed, bool encrypted, std::string destDirectory) : compressed(compressed),
-                                                                                 encrypted(encrypted),
-                                                                                 destDirectory(std::move(destDirectory)) {}
+    // Compress in independent blocks with an index, so ranges can be read without inflating the whole file (version 5 and later)
+    bool seekable;
+
+    // The codec to compress with, one of the DATCODEC values (anything but ZLib needs version 6 or later)
+    uint8_t codec;
+
+    // The filetype identifier, see File Spec.txt, small files of a type share that type's dictionary if the writer has one
+    uint8_t fileType;
+
+    FileDescriptor(bool compressed, bool encrypted, std::string destDirectory, bool seekable = false, uint8_t codec = 0, uint8_t fileType = 0) : compressed(compressed),
+                                                                                                                                                 encrypted(encrypted),
+                                                                                                                                                 destDirectory(std::move(destDirectory)),
+                                                                                                                                                 seekable(seekable),
+                                                                                                                                                 codec(codec),
+                                                                                                                                                 fileType(fileType) {}
 };
 
 struct FileFlags {
@@ -82,6 +167,30 @@ struct DatFileEntry {
 	int64_t dataStart = 0;
 	int64_t dataEnd = 0;
 
+	// The codec the entry was compressed with, always ZLib before version 6
+	uint8_t codec = 0;
+
+	// The dictionary the entry was compressed against, 0 for none, otherwise the index in the table's dictionary index plus one (version 7 and later)
+	uint8_t dictionary = 0;
+
+	// The solid block holding the entry, 0 for none, otherwise its index in the table's solid index plus one (version 8 and later)
+	// The data start and end of an entry in a solid block are where it is in the block once the block is decompressed
+	uint32_t solidBlock = 0;
+
+	// The entry's blocks in the table's block index, a block count of 0 means the entry has none (version 5 and later)
+	uint32_t firstBlock = 0;
+	uint32_t blockCount = 0;
+
+	// The xxHash64 of the stored data, checked instead of the crc when the table's checksum is DATCHECKSUMXXH64 (version 9 and later)
+	uint64_t hash = 0;
+
+	// Which of the crc and hash the entry is checked against, one of the DATCHECKSUM values, comes from the table header rather than the record
+	uint8_t checksum = DATCHECKSUMCRC32;
+
+	// Where the entry is in the open archive's table, its record's index or for a solid block the entry count plus its index in the solid index
+	// Used to remember which entries have been verified, entries that didn't come from a table have none
+	uint64_t tableIndex = UINT64_MAX;
+
     /**
      * Gets the size of the file (after decompression/decryption if required
      * @return The amount of bytes required to store the file in memory
@@ -90,6 +199,66 @@ struct DatFileEntry {
         return (size_t) dataSize;
     }
 
+	/**
+	 * Reads the entry from a version 3 or later table record
+	 * @param Record A pointer to the start of the record
+	 * @param RecordSize The size of the record, fields past the end of older records are left at their defaults
+	 */
+	void readRecord(const char* Record, size_t RecordSize) {
+		memcpy(&dataSize, Record, 8);
+		memcpy(&dataStart, Record + 8, 8);
+		memcpy(&dataEnd, Record + 16, 8);
+		memcpy(&crc, Record + 28, 4);
+
+		uint8_t desc = (uint8_t) Record[33];
+		flags.setFlags(desc);
+		fileType = desc & 0b00111111;
+		codec = (uint8_t) Record[34];
+		dictionary = (uint8_t) Record[35];
+		memcpy(&solidBlock, Record + 36, 4);
+
+		if (RecordSize >= 48) {
+			memcpy(&firstBlock, Record + 40, 4);
+			memcpy(&blockCount, Record + 44, 4);
+		}
+
+		if (RecordSize >= 56) {
+			memcpy(&hash, Record + 48, 8);
+		}
+	}
+
+	/**
+	 * Writes the entry into a table record, older versions only write the start of it
+	 * @param Record A pointer to the start of the record, DATFILERECORDSIZE bytes long
+	 * @param NameOffset The offset of the entry's name in the name pool
+	 * @param NameLength The length of the entry's name
+	 */
+	void writeRecord(char* Record, uint32_t NameOffset, uint8_t NameLength) const {
+		memset(Record, 0, DATFILERECORDSIZE);
+		memcpy(Record, &dataSize, 8);
+		memcpy(Record + 8, &dataStart, 8);
+		memcpy(Record + 16, &dataEnd, 8);
+		memcpy(Record + 24, &NameOffset, 4);
+		memcpy(Record + 28, &crc, 4);
+		Record[32] = (char) NameLength;
+		Record[33] = (char) getTypeAndFlags();
+		Record[34] = (char) codec;
+		Record[35] = (char) dictionary;
+		memcpy(Record + 36, &solidBlock, 4);
+		memcpy(Record + 40, &firstBlock, 4);
+		memcpy(Record + 44, &blockCount, 4);
+		memcpy(Record + 48, &hash, 8);
+	}
+
+	/**
+	 * Stores the checksum of the entry's data in whichever of the crc and hash it is checked against
+	 * @param Value The checksum, from a DatChecksum of the entry's checksum type
+	 */
+	void setChecksum(uint64_t Value) {
+		if (checksum == DATCHECKSUMXXH64) hash = Value;
+		else crc = (uint32_t) Value;
+	}
+
 	/**
 	 * Gets the filetype and flags as a byte
 	 * @return a byte containing the filetype and flags ready for writing to a file
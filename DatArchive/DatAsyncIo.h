@@ -0,0 +1,340 @@
+#pragma once
+#include <DatArchive/DatPositionalFile.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// io_uring is used through its system calls directly, so there's nothing extra to link against
+// Defining DATARCHIVE_NO_IO_URING leaves it out, and every async read runs on a thread pool instead
+#if defined(__linux__) && !defined(DATARCHIVE_NO_IO_URING) && __has_include(<linux/io_uring.h>)
+#define DATARCHIVE_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+/**
+ * Keeps many reads of one file in flight from a single I/O thread, using io_uring
+ * Reads can be queued from any thread, the I/O thread submits them in batches and calls their completions, so completions should only hand work off
+ * Only available on Linux, create returns nullptr anywhere else, or if the kernel won't set up a ring, so the caller can fall back to blocking reads
+ */
+class DatAsyncIo {
+public:
+	/**
+	 * Called on the I/O thread once a read has finished
+	 */
+	using Completion = std::function<void(bool Success)>;
+
+	// The most reads in flight at once, the rest wait in the queue
+	static const unsigned QUEUEDEPTH = 256;
+
+private:
+#ifdef DATARCHIVE_HAS_IO_URING
+	// A read can only return 32 bits worth of length, so longer reads are submitted in pieces of this size
+	static constexpr size_t MAXPIECE = 1 << 30;
+
+	struct Request {
+		int64_t offset = 0;
+		char* buffer = nullptr;
+		size_t length = 0;
+		Completion done;
+
+		// Read by the kernel while the request is in flight
+		iovec piece{};
+	};
+
+	int fileDescriptor = -1;
+	int ringDescriptor = -1;
+
+	// Written to by other threads to wake the I/O thread, which always has a read of it in flight
+	int wakeDescriptor = -1;
+	uint64_t wakeValue = 0;
+	iovec wakePiece{};
+
+	// The rings shared with the kernel
+	void* sqRing = nullptr;
+	size_t sqRingSize = 0;
+	void* cqRing = nullptr;
+	size_t cqRingSize = 0;
+	io_uring_sqe* sqes = nullptr;
+	size_t sqesSize = 0;
+
+	unsigned* sqHead = nullptr;
+	unsigned* sqTail = nullptr;
+	unsigned* sqArray = nullptr;
+	unsigned sqMask = 0;
+	unsigned sqEntries = 0;
+
+	unsigned* cqHead = nullptr;
+	unsigned* cqTail = nullptr;
+	io_uring_cqe* cqes = nullptr;
+	unsigned cqMask = 0;
+
+	std::mutex mutex;
+	std::deque<std::unique_ptr<Request>> queued;
+	bool stopping = false;
+	std::thread ioThread;
+
+	/**
+	 * Sets up the ring
+	 * @param File The file to read from
+	 * @return Whether the kernel set up the ring
+	 */
+	bool setup(const DatPositionalFile& File) {
+		fileDescriptor = File.descriptor();
+		if (fileDescriptor == -1) return false;
+
+		io_uring_params params{};
+		ringDescriptor = (int) syscall(__NR_io_uring_setup, QUEUEDEPTH, &params);
+		if (ringDescriptor < 0) return false;
+
+		sqEntries = params.sq_entries;
+		sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+		// Newer kernels share one mapping between both rings
+		bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (singleMapping) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+		sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQ_RING);
+		if (sqRing == MAP_FAILED) {
+			sqRing = nullptr;
+			return false;
+		}
+
+		if (singleMapping) {
+			cqRing = sqRing;
+		} else {
+			cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_CQ_RING);
+			if (cqRing == MAP_FAILED) {
+				cqRing = nullptr;
+				return false;
+			}
+		}
+
+		sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		void* sqeMapping = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQES);
+		if (sqeMapping == MAP_FAILED) return false;
+		sqes = static_cast<io_uring_sqe*>(sqeMapping);
+
+		char* sq = static_cast<char*>(sqRing);
+		sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+		sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+		sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+		sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+
+		char* cq = static_cast<char*>(cqRing);
+		cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+		cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+		cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+		cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+
+		wakeDescriptor = eventfd(0, EFD_CLOEXEC);
+		if (wakeDescriptor == -1) return false;
+		wakePiece.iov_base = &wakeValue;
+		wakePiece.iov_len = sizeof(wakeValue);
+
+		ioThread = std::thread(&DatAsyncIo::ioLoop, this);
+		return true;
+	}
+
+	/**
+	 * Puts a read in the submission ring, must only be called from the I/O thread with a free slot in the ring
+	 * @param Descriptor The file to read from
+	 * @param Offset The offset in the file to read from
+	 * @param Piece Where to read to
+	 * @param UserData Handed back with the completion
+	 */
+	void prepareRead(int Descriptor, int64_t Offset, iovec* Piece, uint64_t UserData) {
+		unsigned tail = *sqTail;
+		unsigned index = tail & sqMask;
+
+		io_uring_sqe* sqe = &sqes[index];
+		memset(sqe, 0, sizeof(io_uring_sqe));
+		sqe->opcode = IORING_OP_READV;
+		sqe->fd = Descriptor;
+		sqe->off = (uint64_t) Offset;
+		sqe->addr = (uint64_t) (uintptr_t) Piece;
+		sqe->len = 1;
+		sqe->user_data = UserData;
+
+		sqArray[index] = index;
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+	}
+
+	/**
+	 * Submits the queued reads and handles their completions, until the reader is stopped and everything in flight has finished
+	 */
+	void ioLoop() {
+		std::deque<std::unique_ptr<Request>> waiting;
+		unsigned inFlight = 0;
+		bool wakeArmed = false;
+
+		while (true) {
+			bool stop;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				while (!queued.empty()) {
+					waiting.push_back(std::move(queued.front()));
+					queued.pop_front();
+				}
+				stop = stopping;
+			}
+
+			// The read of the wake eventfd isn't put back once stopping, the destructor's wake is the last one
+			if (stop && !wakeArmed && waiting.empty() && inFlight == 0) return;
+
+			// Every read gets a slot in the submission ring and room in the completion ring, so neither can overflow
+			if (!wakeArmed && !stop) {
+				prepareRead(wakeDescriptor, 0, &wakePiece, 0);
+				wakeArmed = true;
+			}
+			while (!waiting.empty() && inFlight + (wakeArmed ? 1 : 0) < sqEntries) {
+				Request* request = waiting.front().release();
+				waiting.pop_front();
+
+				request->piece.iov_base = request->buffer;
+				request->piece.iov_len = std::min(request->length, MAXPIECE);
+				prepareRead(fileDescriptor, request->offset, &request->piece, (uint64_t) (uintptr_t) request);
+				++inFlight;
+			}
+
+			// Submit everything the kernel hasn't taken yet, and wait for at least one completion
+			unsigned toSubmit = *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+			int rc = (int) syscall(__NR_io_uring_enter, ringDescriptor, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (rc < 0 && errno != EINTR) {
+				// Out of resources, back off and let what's in flight finish
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			unsigned head = *cqHead;
+			unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+			std::deque<std::unique_ptr<Request>> finished;
+			std::deque<std::unique_ptr<Request>> failed;
+
+			for (; head != tail; ++head) {
+				const io_uring_cqe& cqe = cqes[head & cqMask];
+				if (cqe.user_data == 0) {
+					wakeArmed = false;
+					continue;
+				}
+
+				std::unique_ptr<Request> request(reinterpret_cast<Request*>((uintptr_t) cqe.user_data));
+				--inFlight;
+
+				// Short reads are carried on from where they stopped, reading nothing means the file ended early
+				if (cqe.res > 0) {
+					request->offset += cqe.res;
+					request->buffer += cqe.res;
+					request->length -= (size_t) cqe.res;
+
+					if (request->length == 0) finished.push_back(std::move(request));
+					else waiting.push_front(std::move(request));
+				} else if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+					waiting.push_front(std::move(request));
+				} else {
+					failed.push_back(std::move(request));
+				}
+			}
+			__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+			for (auto& request : finished) request->done(true);
+			for (auto& request : failed) request->done(false);
+		}
+	}
+
+	/**
+	 * Frees everything setup made
+	 */
+	void release() {
+		if (sqes != nullptr) munmap(sqes, sqesSize);
+		if (cqRing != nullptr && cqRing != sqRing) munmap(cqRing, cqRingSize);
+		if (sqRing != nullptr) munmap(sqRing, sqRingSize);
+		if (wakeDescriptor != -1) ::close(wakeDescriptor);
+		if (ringDescriptor >= 0) ::close(ringDescriptor);
+	}
+#endif
+
+	DatAsyncIo() = default;
+
+public:
+	DatAsyncIo(const DatAsyncIo&) = delete;
+	DatAsyncIo& operator=(const DatAsyncIo&) = delete;
+
+	/**
+	 * Waits for every read in flight to finish, then shuts down the ring
+	 */
+	~DatAsyncIo() {
+#ifdef DATARCHIVE_HAS_IO_URING
+		if (ioThread.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			uint64_t one = 1;
+			while (write(wakeDescriptor, &one, sizeof(one)) == -1 && errno == EINTR) {}
+			ioThread.join();
+		}
+		release();
+#endif
+	}
+
+	/**
+	 * Sets up a ring for reading a file
+	 * @param File The file to read from, which must stay open for as long as the reader exists
+	 * @return The reader, or nullptr if io_uring isn't available
+	 */
+	static std::unique_ptr<DatAsyncIo> create(const DatPositionalFile& File) {
+#ifdef DATARCHIVE_HAS_IO_URING
+		std::unique_ptr<DatAsyncIo> io(new DatAsyncIo());
+		if (io->setup(File)) return io;
+#endif
+		(void) File;
+		return nullptr;
+	}
+
+	/**
+	 * Queues a read, returning straight away
+	 * @param Offset The offset in the file of the first byte to read
+	 * @param Buffer The buffer to read into, which must stay alive until the read completes (assumed to be big enough for Length bytes)
+	 * @param Length The amount of bytes to read
+	 * @param Done Called on the I/O thread with whether all of the bytes were read
+	 */
+	void read(int64_t Offset, char* Buffer, size_t Length, Completion Done) {
+#ifdef DATARCHIVE_HAS_IO_URING
+		if (Offset < 0 || Length == 0) {
+			Done(Offset >= 0);
+			return;
+		}
+
+		auto request = std::make_unique<Request>();
+		request->offset = Offset;
+		request->buffer = Buffer;
+		request->length = Length;
+		request->done = std::move(Done);
+
+		// Wake under the lock, so the reader can't be destroyed part way through, and only once until the I/O thread takes the queue
+		std::lock_guard<std::mutex> lock(mutex);
+		bool wake = queued.empty();
+		queued.push_back(std::move(request));
+
+		uint64_t one = 1;
+		while (wake && write(wakeDescriptor, &one, sizeof(one)) == -1 && errno == EINTR) {}
+#else
+		(void) Offset;
+		(void) Buffer;
+		(void) Length;
+		Done(false);
+#endif
+	}
+};
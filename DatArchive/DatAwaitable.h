@@ -0,0 +1,65 @@
+#pragma once
+#include <functional>
+#include <utility>
+
+// Only built with C++20 or later, turned on for the CMake target by DATARCHIVE_CXX20
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define DATARCHIVE_HAS_COROUTINES
+#include <coroutine>
+
+/**
+ * Runs a piece of work, picking the thread a coroutine carries on from once its read is done
+ * An empty executor carries on straight away, from whichever thread finished the read
+ * A thread pool can be used with [&Pool](std::function<void()> Work) { Pool.submit(std::move(Work)); }
+ */
+using DatExecutor = std::function<void(std::function<void()>)>;
+
+/**
+ * Suspends a coroutine until a read has finished, then resumes it through an executor, co_await gives the result of the read
+ * The read only starts once the awaitable is awaited, and each awaitable can only be awaited once
+ */
+template<typename Result>
+class DatReadAwaitable {
+public:
+	/**
+	 * Starts the read, calling its argument with the result once the read has finished
+	 */
+	using Start = std::function<void(std::function<void(Result&&)>)>;
+
+private:
+	Start start;
+	DatExecutor executor;
+	Result result{};
+
+public:
+	/**
+	 * Creates the awaitable
+	 * @param Begin Starts the read
+	 * @param Executor Where to resume the coroutine, empty to resume it on the thread that finished the read
+	 */
+	DatReadAwaitable(Start Begin, DatExecutor Executor) : start(std::move(Begin)), executor(std::move(Executor)) {}
+
+	bool await_ready() const noexcept {
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> Handle) {
+		// The read can finish and resume the coroutine before this returns, so the awaitable isn't touched once it has started
+		Start begin = std::move(start);
+		begin([this, Handle, run = std::move(executor)](Result&& Data) {
+			result = std::move(Data);
+			if (run) {
+				run([Handle]() {
+					Handle.resume();
+				});
+			} else {
+				Handle.resume();
+			}
+		});
+	}
+
+	Result await_resume() {
+		return std::move(result);
+	}
+};
+#endif
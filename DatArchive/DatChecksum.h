@@ -0,0 +1,457 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <zlib.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DATCHECKSUM_X86
+#include <immintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && (defined(__linux__) || defined(__APPLE__))
+#define DATCHECKSUM_ARM
+#include <arm_acle.h>
+#ifdef __linux__
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+
+#if defined(DATCHECKSUM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define DATCHECKSUM_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#define DATCHECKSUM_TARGET_PCLMUL
+#endif
+
+#if defined(DATCHECKSUM_ARM)
+#define DATCHECKSUM_TARGET_CRC __attribute__((target("+crc")))
+#endif
+
+// The checksum each entry is checked against, stored in the table header from version 9, see File Spec.txt
+static const uint8_t DATCHECKSUMCRC32 = 0;
+static const uint8_t DATCHECKSUMXXH64 = 1;
+
+/**
+ * The 64 bit xxHash, a non cryptographic hash with far fewer collisions than a CRC32 that runs at memory speed on any CPU, accelerated or not
+ * Can be fed data a piece at a time, giving the same hash as hashing it all at once
+ */
+class DatXxh64 {
+	static const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+	static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+	static const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+	static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+	static const uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+	uint64_t lanes[4];
+	uint64_t totalLength = 0;
+	unsigned char buffer[32];
+	size_t buffered = 0;
+	uint64_t seed;
+
+	static uint64_t rotl(uint64_t Value, int Bits) {
+		return (Value << Bits) | (Value >> (64 - Bits));
+	}
+
+	static uint64_t read64(const unsigned char* Ptr) {
+		uint64_t value;
+		memcpy(&value, Ptr, 8);
+		return value;
+	}
+
+	static uint32_t read32(const unsigned char* Ptr) {
+		uint32_t value;
+		memcpy(&value, Ptr, 4);
+		return value;
+	}
+
+	static uint64_t round(uint64_t Accumulator, uint64_t Input) {
+		Accumulator += Input * PRIME2;
+		Accumulator = rotl(Accumulator, 31);
+		return Accumulator * PRIME1;
+	}
+
+	static uint64_t mergeRound(uint64_t Accumulator, uint64_t Lane) {
+		Accumulator ^= round(0, Lane);
+		return Accumulator * PRIME1 + PRIME4;
+	}
+
+	/**
+	 * Consumes whole 32 byte stripes
+	 * @param Data The stripes
+	 * @param Stripes The amount of stripes
+	 */
+	void consume(const unsigned char* Data, size_t Stripes) {
+		uint64_t v1 = lanes[0], v2 = lanes[1], v3 = lanes[2], v4 = lanes[3];
+		for (size_t i = 0; i < Stripes; ++i, Data += 32) {
+			v1 = round(v1, read64(Data));
+			v2 = round(v2, read64(Data + 8));
+			v3 = round(v3, read64(Data + 16));
+			v4 = round(v4, read64(Data + 24));
+		}
+		lanes[0] = v1;
+		lanes[1] = v2;
+		lanes[2] = v3;
+		lanes[3] = v4;
+	}
+
+public:
+	explicit DatXxh64(uint64_t Seed = 0) {
+		reset(Seed);
+	}
+
+	/**
+	 * Starts a new hash
+	 * @param Seed The seed for the hash
+	 */
+	void reset(uint64_t Seed = 0) {
+		seed = Seed;
+		lanes[0] = Seed + PRIME1 + PRIME2;
+		lanes[1] = Seed + PRIME2;
+		lanes[2] = Seed;
+		lanes[3] = Seed - PRIME1;
+		totalLength = 0;
+		buffered = 0;
+	}
+
+	/**
+	 * Adds data to the hash
+	 * @param Data The data to add
+	 * @param Size The amount of bytes
+	 */
+	void update(const void* Data, size_t Size) {
+		const unsigned char* data = static_cast<const unsigned char*>(Data);
+		totalLength += Size;
+
+		// Finish off a partly filled stripe first
+		if (buffered != 0) {
+			size_t take = Size < 32 - buffered ? Size : 32 - buffered;
+			memcpy(buffer + buffered, data, take);
+			buffered += take;
+			data += take;
+			Size -= take;
+
+			if (buffered < 32) return;
+			consume(buffer, 1);
+			buffered = 0;
+		}
+
+		consume(data, Size / 32);
+		data += Size / 32 * 32;
+		Size %= 32;
+
+		memcpy(buffer, data, Size);
+		buffered = Size;
+	}
+
+	/**
+	 * Gets the hash of everything added so far
+	 * @return The hash
+	 */
+	[[nodiscard]] uint64_t digest() const {
+		uint64_t hash;
+		if (totalLength >= 32) {
+			hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+			for (uint64_t lane : lanes) hash = mergeRound(hash, lane);
+		} else {
+			hash = seed + PRIME5;
+		}
+		hash += totalLength;
+
+		const unsigned char* data = buffer;
+		size_t remaining = buffered;
+		for (; remaining >= 8; remaining -= 8, data += 8) {
+			hash ^= round(0, read64(data));
+			hash = rotl(hash, 27) * PRIME1 + PRIME4;
+		}
+		if (remaining >= 4) {
+			hash ^= (uint64_t) read32(data) * PRIME1;
+			hash = rotl(hash, 23) * PRIME2 + PRIME3;
+			data += 4;
+			remaining -= 4;
+		}
+		for (; remaining > 0; --remaining, ++data) {
+			hash ^= *data * PRIME5;
+			hash = rotl(hash, 11) * PRIME1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= PRIME2;
+		hash ^= hash >> 29;
+		hash *= PRIME3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	/**
+	 * Hashes a buffer in one go
+	 * @param Data The data to hash
+	 * @param Size The amount of bytes
+	 * @param Seed The seed for the hash
+	 * @return The hash
+	 */
+	static uint64_t hash(const void* Data, size_t Size, uint64_t Seed = 0) {
+		DatXxh64 state(Seed);
+		state.update(Data, Size);
+		return state.digest();
+	}
+};
+
+/**
+ * The checksums used to check entries, picking the fastest CRC32 the CPU can run the first time one is needed
+ * x86 CPUs with PCLMULQDQ fold 64 bytes at a time with carry-less multiplies, ARMv8 CPUs with the CRC extension use its CRC32 instructions, anything else uses ZLib's
+ */
+namespace DatCrc32 {
+	/**
+	 * A CRC32 kernel, taking and returning the CRC the same way as ZLib's crc32
+	 */
+	using Kernel = uint32_t (*)(uint32_t Crc, const unsigned char* Data, size_t Size);
+
+	/**
+	 * Runs ZLib's CRC32, a table driven kernel that works everywhere
+	 */
+	inline uint32_t zlibKernel(uint32_t Crc, const unsigned char* Data, size_t Size) {
+		// ZLib only takes 32 bits worth of length at a time
+		while (Size > 0) {
+			uInt chunk = Size > 0x40000000u ? 0x40000000u : (uInt) Size;
+			Crc = (uint32_t) ::crc32(Crc, Data, chunk);
+			Data += chunk;
+			Size -= chunk;
+		}
+		return Crc;
+	}
+
+#ifdef DATCHECKSUM_X86
+	/**
+	 * Folds a buffer down to its CRC32 with carry-less multiplies, following Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ"
+	 * @param Crc The CRC so far, already inverted
+	 * @param Data The data, at least 64 bytes
+	 * @param Size The amount of bytes, a multiple of 16
+	 * @return The CRC, still inverted
+	 */
+	DATCHECKSUM_TARGET_PCLMUL inline uint32_t foldPclmul(uint32_t Crc, const unsigned char* Data, size_t Size) {
+		alignas(16) static const uint64_t k1k2[] = {0x0154442bd4ull, 0x01c6e41596ull};
+		alignas(16) static const uint64_t k3k4[] = {0x01751997d0ull, 0x00ccaa009eull};
+		alignas(16) static const uint64_t k5k0[] = {0x0163cd6124ull, 0x0000000000ull};
+		alignas(16) static const uint64_t poly[] = {0x01db710641ull, 0x01f7011641ull};
+
+		__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+		x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data));
+		x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 16));
+		x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 32));
+		x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 48));
+		x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) Crc));
+
+		x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+		Data += 64;
+		Size -= 64;
+
+		// Fold 4 lanes of 128 bits forward by 512 bits at a time
+		while (Size >= 64) {
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+			x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+			x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+			x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+			x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data)));
+			x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 16)));
+			x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 32)));
+			x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + 48)));
+
+			Data += 64;
+			Size -= 64;
+		}
+
+		// Fold the 4 lanes into 1
+		x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+		// Fold in whatever 16 byte blocks are left
+		while (Size >= 16) {
+			x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data));
+
+			x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+			Data += 16;
+			Size -= 16;
+		}
+
+		// Fold 128 bits down to 64
+		x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+		x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+		x1 = _mm_srli_si128(x1, 8);
+		x1 = _mm_xor_si128(x1, x2);
+
+		x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+
+		x2 = _mm_srli_si128(x1, 4);
+		x1 = _mm_and_si128(x1, x3);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+
+		// Barrett reduce down to 32 bits
+		x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+		x2 = _mm_and_si128(x1, x3);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+		x2 = _mm_and_si128(x2, x3);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+
+		return (uint32_t) _mm_extract_epi32(x1, 1);
+	}
+
+	/**
+	 * Runs the PCLMULQDQ kernel over the bulk of the data, and ZLib's over anything too short to fold
+	 */
+	inline uint32_t pclmulKernel(uint32_t Crc, const unsigned char* Data, size_t Size) {
+		if (Size >= 64) {
+			size_t bulk = Size & ~(size_t) 15;
+			Crc = ~foldPclmul(~Crc, Data, bulk);
+			Data += bulk;
+			Size -= bulk;
+		}
+		return zlibKernel(Crc, Data, Size);
+	}
+
+	/**
+	 * Checks if the CPU has PCLMULQDQ and SSE4.1
+	 */
+	inline bool hasPclmul() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 1)) != 0 && (info[2] & (1 << 19)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+	}
+#endif
+
+#ifdef DATCHECKSUM_ARM
+	/**
+	 * Runs the ARMv8 CRC32 instructions, which use the same polynomial as ZLib
+	 */
+	DATCHECKSUM_TARGET_CRC inline uint32_t armKernel(uint32_t Crc, const unsigned char* Data, size_t Size) {
+		Crc = ~Crc;
+		for (; Size >= 8; Size -= 8, Data += 8) {
+			uint64_t value;
+			memcpy(&value, Data, 8);
+			Crc = __crc32d(Crc, value);
+		}
+		for (; Size > 0; --Size, ++Data) {
+			Crc = __crc32b(Crc, *Data);
+		}
+		return ~Crc;
+	}
+
+	/**
+	 * Checks if the CPU has the CRC extension
+	 */
+	inline bool hasArmCrc() {
+#ifdef __APPLE__
+		return true;
+#else
+		return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif
+	}
+#endif
+
+	/**
+	 * Picks the fastest kernel the CPU can run
+	 * @return The kernel
+	 */
+	inline Kernel pickKernel() {
+#ifdef DATCHECKSUM_X86
+		if (hasPclmul()) return pclmulKernel;
+#endif
+#ifdef DATCHECKSUM_ARM
+		if (hasArmCrc()) return armKernel;
+#endif
+		return zlibKernel;
+	}
+
+	/**
+	 * Gets the kernel used by compute, picked once on first use
+	 * @return The kernel
+	 */
+	inline Kernel kernel() {
+		static const Kernel picked = pickKernel();
+		return picked;
+	}
+
+	/**
+	 * Updates a CRC32 with more data, giving the same result as ZLib's crc32
+	 * @param Crc The CRC so far, 0 to start a new one
+	 * @param Data The data to add
+	 * @param Size The amount of bytes
+	 * @return The updated CRC
+	 */
+	inline uint32_t compute(uint32_t Crc, const void* Data, size_t Size) {
+		return kernel()(Crc, static_cast<const unsigned char*>(Data), Size);
+	}
+}
+
+/**
+ * A running checksum of one of the DATCHECKSUM types, fed a piece at a time as an entry is written
+ */
+class DatChecksum {
+	uint8_t type;
+	uint32_t crc = 0;
+	DatXxh64 xxh;
+
+public:
+	explicit DatChecksum(uint8_t Type = DATCHECKSUMCRC32) : type(Type) {}
+
+	/**
+	 * Adds data to the checksum
+	 * @param Data The data to add
+	 * @param Size The amount of bytes
+	 */
+	void update(const void* Data, size_t Size) {
+		if (type == DATCHECKSUMXXH64) xxh.update(Data, Size);
+		else crc = DatCrc32::compute(crc, Data, Size);
+	}
+
+	/**
+	 * Gets the checksum of everything added so far
+	 * @return The checksum, a CRC32 is in the low 32 bits
+	 */
+	[[nodiscard]] uint64_t digest() const {
+		return type == DATCHECKSUMXXH64 ? xxh.digest() : crc;
+	}
+
+	/**
+	 * Checksums a buffer in one go
+	 * @param Type The type of checksum
+	 * @param Data The data to checksum
+	 * @param Size The amount of bytes
+	 * @return The checksum
+	 */
+	static uint64_t compute(uint8_t Type, const void* Data, size_t Size) {
+		if (Type == DATCHECKSUMXXH64) return DatXxh64::hash(Data, Size);
+		return DatCrc32::compute(0, Data, Size);
+	}
+};
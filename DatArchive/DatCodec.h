@@ -0,0 +1,165 @@
+#pragma once
+#include <DatArchive/DatInflater.h>
+#include <DatArchive/DatLz4.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <zlib.h>
+
+#ifdef DATARCHIVE_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+// The codec a compressed entry was compressed with, stored in its record from version 6, see File Spec.txt
+static const uint8_t DATCODECZLIB = 0;
+static const uint8_t DATCODECLZ4 = 1;
+static const uint8_t DATCODECZSTD = 2;
+
+/**
+ * A compression codec, compressing and decompressing one chunk of an entry at a time
+ * ZLib entries are a single zlib stream, entries using any other codec are a run of chunks each holding up to DATFILEBLOCKSIZE bytes of the file
+ */
+class DatCodec {
+public:
+	virtual ~DatCodec() = default;
+
+	/**
+	 * Gets the name of the codec, for reporting
+	 * @return The name of the codec
+	 */
+	[[nodiscard]] virtual const char* name() const = 0;
+
+	/**
+	 * Gets the most bytes compressing a chunk can produce
+	 * @param InSize The size of the uncompressed chunk
+	 * @return The size to allocate for the compressed chunk
+	 */
+	[[nodiscard]] virtual size_t compressBound(size_t InSize) const = 0;
+
+	/**
+	 * Compresses a chunk
+	 * @param In The uncompressed chunk
+	 * @param InSize The size of the uncompressed chunk
+	 * @param Out The buffer for the compressed chunk, at least compressBound(InSize) bytes
+	 * @param Level The compression level, Z_DEFAULT_COMPRESSION uses the codec's own default
+	 * @return The size of the compressed chunk, or 0 if it couldn't be compressed
+	 */
+	virtual size_t compress(const char* In, size_t InSize, char* Out, int Level) const = 0;
+
+	/**
+	 * Decompresses a chunk
+	 * @param In The compressed chunk
+	 * @param InSize The size of the compressed chunk
+	 * @param Out The buffer for the uncompressed chunk
+	 * @param OutSize The size of the uncompressed chunk
+	 * @return Whether the chunk decompressed to exactly OutSize bytes
+	 */
+	virtual bool decompress(const char* In, size_t InSize, char* Out, size_t OutSize) const = 0;
+
+	/**
+	 * Gets the codec for an id
+	 * @param Id The id of the codec, one of the DATCODEC values
+	 * @return The codec, or nullptr if it is unknown or wasn't built in
+	 */
+	static const DatCodec* get(uint8_t Id);
+};
+
+/**
+ * ZLib as a chunk codec, entries compressed with ZLib are still written as one stream rather than chunks
+ */
+class DatZlibCodec : public DatCodec {
+public:
+	[[nodiscard]] const char* name() const override {
+		return "zlib";
+	}
+
+	[[nodiscard]] size_t compressBound(size_t InSize) const override {
+		return ::compressBound((uLong) InSize);
+	}
+
+	size_t compress(const char* In, size_t InSize, char* Out, int Level) const override {
+		uLongf outSize = ::compressBound((uLong) InSize);
+		if (compress2(reinterpret_cast<Bytef*>(Out), &outSize, reinterpret_cast<const Bytef*>(In), (uLong) InSize, Level) != Z_OK) return 0;
+		return outSize;
+	}
+
+	bool decompress(const char* In, size_t InSize, char* Out, size_t OutSize) const override {
+		z_stream* strm;
+		if (DatInflater::forThread().begin(strm) != Z_OK) return false;
+
+		strm->avail_in = (uInt) InSize;
+		strm->next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(In));
+		strm->avail_out = (uInt) OutSize;
+		strm->next_out = reinterpret_cast<unsigned char*>(Out);
+		return inflate(strm, Z_FINISH) == Z_STREAM_END && strm->avail_out == 0;
+	}
+};
+
+/**
+ * LZ4, built in, much faster to decode than ZLib for a lower ratio
+ */
+class DatLz4Codec : public DatCodec {
+public:
+	[[nodiscard]] const char* name() const override {
+		return "lz4";
+	}
+
+	[[nodiscard]] size_t compressBound(size_t InSize) const override {
+		return DatLz4::compressBound(InSize);
+	}
+
+	size_t compress(const char* In, size_t InSize, char* Out, int) const override {
+		return DatLz4::compress(In, InSize, Out);
+	}
+
+	bool decompress(const char* In, size_t InSize, char* Out, size_t OutSize) const override {
+		return DatLz4::decompress(In, InSize, Out, OutSize);
+	}
+};
+
+#ifdef DATARCHIVE_WITH_ZSTD
+/**
+ * Zstandard, only available when built with DATARCHIVE_WITH_ZSTD and linked against libzstd
+ */
+class DatZstdCodec : public DatCodec {
+public:
+	[[nodiscard]] const char* name() const override {
+		return "zstd";
+	}
+
+	[[nodiscard]] size_t compressBound(size_t InSize) const override {
+		return ZSTD_compressBound(InSize);
+	}
+
+	size_t compress(const char* In, size_t InSize, char* Out, int Level) const override {
+		size_t result = ZSTD_compress(Out, ZSTD_compressBound(InSize), In, InSize, Level == Z_DEFAULT_COMPRESSION ? ZSTD_CLEVEL_DEFAULT : Level);
+		return ZSTD_isError(result) ? 0 : result;
+	}
+
+	bool decompress(const char* In, size_t InSize, char* Out, size_t OutSize) const override {
+		size_t result = ZSTD_decompress(Out, OutSize, In, InSize);
+		return !ZSTD_isError(result) && result == OutSize;
+	}
+};
+#endif
+
+inline const DatCodec* DatCodec::get(uint8_t Id) {
+	static const DatZlibCodec zlibCodec;
+	static const DatLz4Codec lz4Codec;
+#ifdef DATARCHIVE_WITH_ZSTD
+	static const DatZstdCodec zstdCodec;
+#endif
+
+	switch (Id) {
+	case DATCODECZLIB:
+		return &zlibCodec;
+	case DATCODECLZ4:
+		return &lz4Codec;
+#ifdef DATARCHIVE_WITH_ZSTD
+	case DATCODECZSTD:
+		return &zstdCodec;
+#endif
+	default:
+		return nullptr;
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+/**
+ * Trains a preset dictionary from sample files, for compressing lots of small files that share content
+ * Works like zstd's fast cover trainer, the samples are split into epochs and the segment of each epoch containing the most 8 byte strings that are common across the samples is kept
+ * The dictionary is plain bytes, usable with zlib's deflateSetDictionary and inflateSetDictionary
+ */
+namespace DatDictionary {
+	// zlib can only look back 32KB, so anything bigger is wasted
+	static const size_t MAXSIZE = 32 * 1024;
+
+	static const size_t DMERSIZE = 8;
+	static constexpr size_t SEGMENTSIZE = 256;
+
+	// At most this much of the samples is looked at, keeping training quick and its memory bounded
+	static const size_t SAMPLELIMIT = 4 * 1024 * 1024;
+
+	static const unsigned HASHBITS = 20;
+	static const uint32_t NOBIN = UINT32_MAX;
+
+	inline uint32_t bin(const char* Data) {
+		uint64_t value;
+		memcpy(&value, Data, 8);
+		return (uint32_t) ((value * 0xCF1BBCDCB7A56463ull) >> (64 - HASHBITS));
+	}
+
+	/**
+	 * Trains a dictionary from samples
+	 * @param Samples The contents of each sample file
+	 * @param Capacity The most bytes the dictionary can hold
+	 * @return The dictionary, with the most useful content at the end where it is cheapest to refer to, or empty if the samples share nothing
+	 */
+	inline std::vector<char> train(const std::vector<std::vector<char>>& Samples, size_t Capacity = MAXSIZE) {
+		// Join the samples together, noting the hash of each 8 byte string that doesn't cross into the next sample
+		std::vector<char> data;
+		std::vector<uint32_t> bins;
+		std::vector<uint32_t> frequency((size_t) 1 << HASHBITS, 0);
+		std::vector<uint32_t> lastSample((size_t) 1 << HASHBITS, NOBIN);
+
+		for (uint32_t sample = 0; sample < (uint32_t) Samples.size() && data.size() < SAMPLELIMIT; ++sample) {
+			const std::vector<char>& contents = Samples[sample];
+			size_t size = std::min(contents.size(), SAMPLELIMIT - data.size());
+			size_t start = data.size();
+			data.insert(data.end(), contents.begin(), contents.begin() + (std::ptrdiff_t) size);
+
+			for (size_t i = 0; i < size; ++i) {
+				if (i + DMERSIZE > size) {
+					bins.push_back(NOBIN);
+					continue;
+				}
+
+				// Frequency is the amount of samples a string is in, not how often it appears
+				uint32_t dmer = bin(data.data() + start + i);
+				bins.push_back(dmer);
+				if (lastSample[dmer] != sample) {
+					lastSample[dmer] = sample;
+					++frequency[dmer];
+				}
+			}
+		}
+
+		// Strings only in one sample aren't worth anything
+		for (uint32_t& it : frequency) {
+			if (it < 2) it = 0;
+		}
+
+		if (data.empty() || Capacity == 0) return {};
+
+		size_t segmentSize = std::min(SEGMENTSIZE, Capacity);
+		size_t epochs = std::max<size_t>(1, Capacity / segmentSize);
+		size_t epochSize = std::max(segmentSize, data.size() / epochs);
+
+		std::vector<uint16_t> inWindow((size_t) 1 << HASHBITS, 0);
+		std::vector<std::tuple<uint64_t, size_t, size_t>> segments;
+
+		for (size_t epochStart = 0; epochStart < data.size() && segments.size() < epochs; epochStart += epochSize) {
+			size_t epochEnd = std::min(data.size(), epochStart + epochSize);
+			size_t windowSize = std::min(segmentSize, epochEnd - epochStart);
+
+			// Slide a window along the epoch, scoring it by the frequency of each distinct string in it
+			uint64_t score = 0;
+			uint64_t bestScore = 0;
+			size_t bestStart = epochStart;
+
+			auto add = [&](size_t Position) {
+				uint32_t dmer = bins[Position];
+				if (dmer != NOBIN && inWindow[dmer]++ == 0) score += frequency[dmer];
+			};
+			auto remove = [&](size_t Position) {
+				uint32_t dmer = bins[Position];
+				if (dmer != NOBIN && --inWindow[dmer] == 0) score -= frequency[dmer];
+			};
+
+			size_t lastDmer = windowSize >= DMERSIZE ? windowSize - DMERSIZE : 0;
+			for (size_t i = 0; i <= lastDmer; ++i) add(epochStart + i);
+			bestScore = score;
+
+			for (size_t start = epochStart + 1; start + windowSize <= epochEnd; ++start) {
+				remove(start - 1);
+				add(start + lastDmer);
+				if (score > bestScore) {
+					bestScore = score;
+					bestStart = start;
+				}
+			}
+
+			// Empty the window for the next epoch
+			for (size_t i = 0; i <= lastDmer; ++i) {
+				uint32_t dmer = bins[epochEnd - windowSize + i];
+				if (dmer != NOBIN) inWindow[dmer] = 0;
+			}
+
+			if (bestScore == 0) continue;
+			segments.emplace_back(bestScore, bestStart, windowSize);
+
+			// Strings already in the dictionary don't make later segments any more useful
+			for (size_t i = 0; i <= lastDmer; ++i) {
+				uint32_t dmer = bins[bestStart + i];
+				if (dmer != NOBIN) frequency[dmer] = 0;
+			}
+		}
+
+		// Put the best segments last, within zlib's cheapest distances
+		std::stable_sort(segments.begin(), segments.end(), [](const auto& A, const auto& B) {
+			return std::get<0>(A) < std::get<0>(B);
+		});
+
+		std::vector<char> dictionary;
+		for (const auto& it : segments) {
+			auto start = data.begin() + (std::ptrdiff_t) std::get<1>(it);
+			dictionary.insert(dictionary.end(), start, start + (std::ptrdiff_t) std::get<2>(it));
+		}
+
+		if (dictionary.size() > Capacity) dictionary.erase(dictionary.begin(), dictionary.end() - (std::ptrdiff_t) Capacity);
+		return dictionary;
+	}
+}
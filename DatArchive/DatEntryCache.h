@@ -0,0 +1,151 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * A decompressed file shared between the cache and everyone reading it, it is never written to once created
+ */
+using DatSharedBuffer = std::shared_ptr<const std::vector<char>>;
+
+/**
+ * Counters describing how well the cache is doing
+ */
+struct DatCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+	size_t bytesUsed = 0;
+	size_t byteBudget = 0;
+};
+
+/**
+ * A least recently used cache of decompressed files, keyed by the index of the file's record
+ * Holds at most byteBudget bytes of file data, evicting the least recently used files to make room
+ * Evicted buffers stay alive for as long as someone still holds them
+ */
+class DatEntryCache {
+	using LruList = std::list<std::pair<uint32_t, DatSharedBuffer>>;
+
+	mutable std::mutex mutex;
+	LruList lru;
+	std::unordered_map<uint32_t, LruList::iterator> lookup;
+	size_t byteBudget = 0;
+	size_t bytesUsed = 0;
+
+	std::atomic<uint64_t> hits{0};
+	std::atomic<uint64_t> misses{0};
+	std::atomic<uint64_t> evictions{0};
+
+	/**
+	 * Evicts the least recently used files until the cache fits in its budget, must be called with the mutex held
+	 */
+	void trim() {
+		while (bytesUsed > byteBudget && !lru.empty()) {
+			bytesUsed -= lru.back().second->size();
+			lookup.erase(lru.back().first);
+			lru.pop_back();
+			evictions.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+public:
+	/**
+	 * Creates the cache
+	 * @param Bytes The budget in bytes, 0 disables the cache
+	 */
+	explicit DatEntryCache(size_t Bytes = 0) : byteBudget(Bytes) {}
+
+	/**
+	 * Sets the most bytes of file data the cache can hold, evicting files if it is already over
+	 * @param Bytes The budget in bytes, 0 disables the cache
+	 */
+	void setBudget(size_t Bytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+		byteBudget = Bytes;
+		trim();
+	}
+
+	/**
+	 * Checks if the cache can hold anything
+	 * @return Whether the cache has a budget
+	 */
+	[[nodiscard]] bool isEnabled() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return byteBudget != 0;
+	}
+
+	/**
+	 * Gets a file from the cache, marking it as the most recently used
+	 * @param Index The index of the file's record
+	 * @return The file's data, or nullptr if it isn't cached
+	 */
+	DatSharedBuffer find(uint32_t Index) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = lookup.find(Index);
+		if (it == lookup.end()) {
+			misses.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		lru.splice(lru.begin(), lru, it->second);
+		hits.fetch_add(1, std::memory_order_relaxed);
+		return it->second->second;
+	}
+
+	/**
+	 * Adds a file to the cache as the most recently used, files bigger than the whole budget aren't kept
+	 * @param Index The index of the file's record
+	 * @param Data The file's data
+	 * @return The cached data, which is what another thread added if it got there first
+	 */
+	DatSharedBuffer insert(uint32_t Index, DatSharedBuffer Data) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = lookup.find(Index);
+		if (it != lookup.end()) {
+			lru.splice(lru.begin(), lru, it->second);
+			return it->second->second;
+		}
+
+		if (Data->size() > byteBudget) return Data;
+
+		lru.emplace_front(Index, Data);
+		lookup[Index] = lru.begin();
+		bytesUsed += Data->size();
+		trim();
+		return Data;
+	}
+
+	/**
+	 * Removes every file from the cache, without counting them as evictions
+	 */
+	void clear() {
+		std::lock_guard<std::mutex> lock(mutex);
+		lru.clear();
+		lookup.clear();
+		bytesUsed = 0;
+	}
+
+	/**
+	 * Gets the counters for the cache
+	 * @return The hits, misses, and evictions so far, and the current size and budget
+	 */
+	[[nodiscard]] DatCacheStats getStats() const {
+		DatCacheStats stats;
+		stats.hits = hits.load(std::memory_order_relaxed);
+		stats.misses = misses.load(std::memory_order_relaxed);
+		stats.evictions = evictions.load(std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		stats.bytesUsed = bytesUsed;
+		stats.byteBudget = byteBudget;
+		return stats;
+	}
+};
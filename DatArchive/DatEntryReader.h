@@ -0,0 +1,399 @@
+#pragma once
+#include <DatArchive/DatArchiveCommon.h>
+#include <DatArchive/DatChecksum.h>
+#include <DatArchive/DatCodec.h>
+#include <DatArchive/DatEntryCache.h>
+#include <DatArchive/DatInflater.h>
+
+#include <functional>
+#include <memory>
+#include <streambuf>
+
+/**
+ * Reads one file out of an archive a window at a time, so files of any size can be fed to a decoder without ever being held in memory whole
+ * It is a std::streambuf, so it can be read through a std::istream, or pulled from directly with read and readChunk
+ * Made by DatFile::openStream, it must not outlive the DatFile it came from, and like any stream is only used by one thread at a time
+ * If the file is being verified, corruption is only found once all of it has been read, so check failed once the end is reached
+ */
+class DatEntryReader : public std::streambuf {
+public:
+	/**
+	 * Reads stored bytes out of the archive
+	 */
+	using ReadFunction = std::function<bool(int64_t Offset, char* Buffer, size_t Length)>;
+
+	/**
+	 * Checks the checksum of all the stored bytes once they've been read
+	 */
+	using VerifyFunction = std::function<bool(uint64_t Checksum)>;
+
+	// The most decoded data held at once, apart from files using codecs other than ZLib, whose chunks are always decoded whole
+	static const size_t WINDOWSIZE = 64 * 1024;
+
+private:
+	// ZLib only takes 32 bits worth of size at a time
+	static constexpr size_t ZLIBWINDOW = 1 << 30;
+
+	DatFileEntry entry;
+	ReadFunction readStored;
+	VerifyFunction verify;
+	DatChecksum checksum;
+	bool isOpen = false;
+	bool hasFailed = false;
+	bool finished = false;
+
+	// Files in a solid block are copied out of the decompressed block
+	DatSharedBuffer block;
+
+	// Decoded data waiting to be handed out, the get area of the streambuf
+	std::vector<char> window;
+
+	// Stored data waiting to be decompressed
+	std::vector<char> input;
+	int64_t storedPosition = 0;
+	int64_t storedSize = 0;
+
+	// The amount of the file decoded so far
+	int64_t decoded = 0;
+
+	// ZLib files are inflated straight into the window
+	std::unique_ptr<DatInflater> inflater;
+	z_stream* strm = nullptr;
+	bool streamEnded = false;
+	const char* dictionary = nullptr;
+	uint32_t dictionarySize = 0;
+
+	// Files using other codecs are decoded a chunk at a time
+	const DatCodec* codec = nullptr;
+	std::vector<char> chunk;
+	size_t chunkPosition = 0;
+
+	/**
+	 * Stops reading, nothing more is handed out once a read has failed
+	 * @return 0, the amount of bytes produced
+	 */
+	size_t fail() {
+		hasFailed = true;
+		setg(window.data(), window.data(), window.data());
+		return 0;
+	}
+
+	/**
+	 * Reads the next stored bytes, adding them to the checksum
+	 * @param To Where to read them to
+	 * @param Length The amount of bytes
+	 * @return Whether they were all read
+	 */
+	bool next(char* To, size_t Length) {
+		if ((int64_t) Length > storedSize - storedPosition || !readStored(entry.dataStart + storedPosition, To, Length)) return false;
+		if (verify) checksum.update(To, Length);
+		storedPosition += (int64_t) Length;
+		return true;
+	}
+
+	/**
+	 * Inflates up to Max bytes of a ZLib file
+	 * @param Out Where to inflate to
+	 * @param Max The most bytes to inflate
+	 * @return The amount of bytes inflated, 0 if it failed
+	 */
+	size_t inflateSome(char* Out, size_t Max) {
+		strm->next_out = reinterpret_cast<unsigned char*>(Out);
+		strm->avail_out = (uInt) std::min(Max, ZLIBWINDOW);
+		size_t wanted = strm->avail_out;
+
+		while (strm->avail_out > 0) {
+			if (strm->avail_in == 0) {
+				size_t length = (size_t) std::min<int64_t>(storedSize - storedPosition, (int64_t) input.size());
+				if (length == 0 || !next(input.data(), length)) return fail();
+				strm->next_in = reinterpret_cast<unsigned char*>(input.data());
+				strm->avail_in = (uInt) length;
+			}
+
+			int rc = inflate(strm, Z_NO_FLUSH);
+
+			// Data compressed against a dictionary stops straight after the header to ask for it
+			if (rc == Z_NEED_DICT) {
+				if (dictionary == nullptr || inflateSetDictionary(strm, reinterpret_cast<const Bytef*>(dictionary), dictionarySize) != Z_OK) return fail();
+				continue;
+			}
+
+			// The stream can only end once the whole file is out
+			if (rc == Z_STREAM_END) {
+				streamEnded = true;
+				if (decoded + (int64_t) (wanted - strm->avail_out) != entry.dataSize) return fail();
+				break;
+			}
+			if (rc != Z_OK) return fail();
+		}
+
+		return wanted - strm->avail_out;
+	}
+
+	/**
+	 * Decodes up to Max bytes of a file using a codec other than ZLib, decoding the next chunk when the current one runs out
+	 * @param Out Where to decode to
+	 * @param Max The most bytes to decode
+	 * @return The amount of bytes decoded, 0 if it failed
+	 */
+	size_t decodeChunks(char* Out, size_t Max) {
+		if (chunkPosition == chunk.size()) {
+			uint32_t chunkSize;
+			if (!next(reinterpret_cast<char*>(&chunkSize), 4)) return fail();
+
+			bool stored = (chunkSize & DATFILECHUNKSTORED) != 0;
+			chunkSize &= ~DATFILECHUNKSTORED;
+
+			// Every chunk holds DATFILEBLOCKSIZE bytes of the file apart from the last
+			chunk.resize((size_t) std::min(entry.dataSize - decoded, DATFILEBLOCKSIZE));
+			chunkPosition = 0;
+
+			if (stored) {
+				if (chunkSize != chunk.size() || !next(chunk.data(), chunkSize)) return fail();
+			} else {
+				if (input.size() < chunkSize) input.resize(chunkSize);
+				if (!next(input.data(), chunkSize) || !codec->decompress(input.data(), chunkSize, chunk.data(), chunk.size())) return fail();
+			}
+		}
+
+		size_t length = std::min(Max, chunk.size() - chunkPosition);
+		memcpy(Out, chunk.data() + chunkPosition, length);
+		chunkPosition += length;
+		return length;
+	}
+
+	/**
+	 * Checks everything was read once the whole file has been decoded, then checks the checksum
+	 * @return Whether the file was read cleanly
+	 */
+	bool finish() {
+		finished = true;
+		if (block) return true;
+
+		if (entry.flags.compressed && entry.codec == DATCODECZLIB && !streamEnded) {
+			// Get to the end of the stream, which can be just the adler32 trailer once all of the data is out
+			unsigned char extra;
+			int rc = Z_OK;
+			while (rc == Z_OK) {
+				strm->next_out = &extra;
+				strm->avail_out = 1;
+				if (strm->avail_in == 0) {
+					size_t length = (size_t) std::min<int64_t>(storedSize - storedPosition, (int64_t) input.size());
+					if (length == 0 || !next(input.data(), length)) return false;
+					strm->next_in = reinterpret_cast<unsigned char*>(input.data());
+					strm->avail_in = (uInt) length;
+				}
+				rc = inflate(strm, Z_NO_FLUSH);
+
+				// Empty files compressed against a dictionary only ask for it here
+				if (rc == Z_NEED_DICT) rc = dictionary != nullptr ? inflateSetDictionary(strm, reinterpret_cast<const Bytef*>(dictionary), dictionarySize) : Z_DATA_ERROR;
+			}
+			if (rc != Z_STREAM_END || strm->avail_out == 0) return false;
+		} else if (entry.flags.compressed && entry.codec != DATCODECZLIB && storedPosition != storedSize) {
+			return false;
+		}
+
+		if (!verify) return true;
+
+		// The checksum covers every stored byte, even any the decoder didn't need
+		while (storedPosition < storedSize) {
+			size_t length = (size_t) std::min<int64_t>(storedSize - storedPosition, (int64_t) input.size());
+			if (!next(input.data(), length)) return false;
+		}
+		return verify(checksum.digest());
+	}
+
+	/**
+	 * Decodes up to Max more bytes of the file
+	 * @param Out Where to decode to
+	 * @param Max The most bytes to decode
+	 * @return The amount of bytes decoded, 0 at the end of the file or if it failed
+	 */
+	size_t produce(char* Out, size_t Max) {
+		if (!isOpen || hasFailed) return 0;
+		if (decoded >= entry.dataSize) {
+			// Empty files still have to be checked
+			if (!finished && !finish()) fail();
+			return 0;
+		}
+		Max = (size_t) std::min<int64_t>((int64_t) Max, entry.dataSize - decoded);
+
+		size_t produced;
+		if (block) {
+			memcpy(Out, block->data() + entry.dataStart + decoded, Max);
+			produced = Max;
+		} else if (!entry.flags.compressed) {
+			if (!next(Out, Max)) return fail();
+			produced = Max;
+		} else if (entry.codec == DATCODECZLIB) {
+			produced = inflateSome(Out, Max);
+		} else {
+			produced = decodeChunks(Out, Max);
+		}
+
+		if (produced == 0) return fail();
+		decoded += (int64_t) produced;
+
+		// Hold back the end of the file until it has been checked
+		if (decoded == entry.dataSize && !finish()) return fail();
+		return produced;
+	}
+
+protected:
+	int_type underflow() override {
+		if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+		size_t produced = produce(window.data(), window.size());
+		if (produced == 0) return traits_type::eof();
+
+		setg(window.data(), window.data(), window.data() + produced);
+		return traits_type::to_int_type(*gptr());
+	}
+
+	std::streamsize xsgetn(char* Buffer, std::streamsize Length) override {
+		return (std::streamsize) read(Buffer, (size_t) Length);
+	}
+
+	std::streamsize showmanyc() override {
+		std::streamsize available = egptr() - gptr();
+		if (available > 0) return available;
+		return hasFailed || decoded >= entry.dataSize ? -1 : 0;
+	}
+
+	pos_type seekoff(off_type Offset, std::ios_base::seekdir Direction, std::ios_base::openmode Which) override {
+		// Only telling where the stream is works, it can't be moved
+		if (Offset != 0 || Direction != std::ios_base::cur || (Which & std::ios_base::in) == 0) return pos_type(off_type(-1));
+		return pos_type(tell());
+	}
+
+public:
+	DatEntryReader() = default;
+
+	/**
+	 * Creates a reader for a file read out of the archive
+	 * @param Entry The table entry for the file
+	 * @param Read Reads stored bytes out of the archive
+	 * @param Verify Checks the checksum of the stored bytes once they've all been read, empty to not check them
+	 * @param Dictionary The preset dictionary the file was compressed against, or nullptr for none
+	 * @param DictionarySize The size of the dictionary
+	 */
+	DatEntryReader(const DatFileEntry& Entry, ReadFunction Read, VerifyFunction Verify, const char* Dictionary = nullptr, uint32_t DictionarySize = 0) : entry(Entry),
+	                                                                                                                                                     readStored(std::move(Read)),
+	                                                                                                                                                     verify(std::move(Verify)),
+	                                                                                                                                                     checksum(Entry.checksum),
+	                                                                                                                                                     window(WINDOWSIZE),
+	                                                                                                                                                     storedSize(Entry.dataEnd - Entry.dataStart + 1),
+	                                                                                                                                                     dictionary(Dictionary),
+	                                                                                                                                                     dictionarySize(DictionarySize) {
+		setg(window.data(), window.data(), window.data());
+		if (entry.dataSize < 0 || storedSize < 0) return;
+
+		if (entry.flags.compressed) {
+			input.resize(WINDOWSIZE);
+
+			if (entry.codec == DATCODECZLIB) {
+				inflater = std::make_unique<DatInflater>();
+				if (inflater->begin(strm) != Z_OK) return;
+				strm->avail_in = 0;
+			} else {
+				codec = DatCodec::get(entry.codec);
+				if (codec == nullptr) return;
+			}
+		}
+
+		isOpen = true;
+	}
+
+	/**
+	 * Creates a reader for a file in a solid block, which must already have been checked
+	 * @param Entry The table entry for the file
+	 * @param Block The decompressed solid block holding the file
+	 */
+	DatEntryReader(const DatFileEntry& Entry, DatSharedBuffer Block) : entry(Entry), block(std::move(Block)), window(WINDOWSIZE) {
+		setg(window.data(), window.data(), window.data());
+		isOpen = block && entry.dataStart >= 0 && entry.dataSize >= 0 && entry.dataStart + entry.dataSize <= (int64_t) block->size();
+	}
+
+	DatEntryReader(const DatEntryReader&) = delete;
+	DatEntryReader& operator=(const DatEntryReader&) = delete;
+
+	// The get area points into the window, whose buffer moves along with it
+	DatEntryReader(DatEntryReader&&) = default;
+	DatEntryReader& operator=(DatEntryReader&&) = default;
+
+	/**
+	 * Checks if the reader has a file to read
+	 */
+	explicit operator bool() const {
+		return isOpen;
+	}
+
+	/**
+	 * Checks if reading failed, because the file couldn't be read, didn't decompress, or didn't match its checksum
+	 * @return Whether reading failed
+	 */
+	[[nodiscard]] bool failed() const {
+		return hasFailed || !isOpen;
+	}
+
+	/**
+	 * Gets the size of the whole file
+	 * @return The size of the file in bytes
+	 */
+	[[nodiscard]] int64_t size() const {
+		return entry.dataSize;
+	}
+
+	/**
+	 * Gets how far through the file reading has got
+	 * @return The amount of bytes handed out so far
+	 */
+	[[nodiscard]] int64_t tell() const {
+		return decoded - (int64_t) (egptr() - gptr());
+	}
+
+	/**
+	 * Reads the next bytes of the file, reads as big as the window are decoded straight into the buffer
+	 * @param Buffer Where to read to
+	 * @param Length The most bytes to read
+	 * @return The amount of bytes read, less than Length at the end of the file or if reading failed
+	 */
+	size_t read(char* Buffer, size_t Length) {
+		size_t total = 0;
+
+		while (total < Length) {
+			size_t buffered = (size_t) (egptr() - gptr());
+			if (buffered > 0) {
+				size_t length = std::min(buffered, Length - total);
+				memcpy(Buffer + total, gptr(), length);
+				setg(eback(), gptr() + length, egptr());
+				total += length;
+				continue;
+			}
+
+			size_t produced;
+			if (Length - total >= window.size()) {
+				produced = produce(Buffer + total, Length - total);
+				total += produced;
+			} else {
+				produced = produce(window.data(), window.size());
+				setg(window.data(), window.data(), window.data() + produced);
+			}
+			if (produced == 0) break;
+		}
+
+		return total;
+	}
+
+	/**
+	 * Reads the next bytes of the file without copying them, handing out the reader's window
+	 * @return A view of the next bytes, only valid until the reader is next used, or an empty view at the end of the file or if reading failed
+	 */
+	DatByteView readChunk() {
+		if (gptr() == egptr()) underflow();
+
+		DatByteView view(reinterpret_cast<const std::byte*>(gptr()), (size_t) (egptr() - gptr()));
+		setg(eback(), egptr(), egptr());
+		return view;
+	}
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <zlib.h>
+
+/**
+ * An inflate stream that is set up once and reset between uses, saving the allocation of the inflate state and window on every decompression
+ * Use forThread to get the calling thread's own instance, or forThreadRaw for one that inflates raw deflate data without a zlib header
+ */
+class DatInflater {
+	z_stream strm{};
+	bool initialised = false;
+	int windowBits = MAX_WBITS;
+
+public:
+	DatInflater() = default;
+
+	explicit DatInflater(int WindowBits) : windowBits(WindowBits) {}
+
+	DatInflater(const DatInflater&) = delete;
+	DatInflater& operator=(const DatInflater&) = delete;
+
+	~DatInflater() {
+		if (initialised) inflateEnd(&strm);
+	}
+
+	/**
+	 * Gets the inflater owned by the calling thread, creating it on first use
+	 * @return The calling thread's inflater
+	 */
+	static DatInflater& forThread() {
+		thread_local DatInflater inflater;
+		return inflater;
+	}
+
+	/**
+	 * Gets the raw inflater owned by the calling thread, for inflating single blocks out of the middle of an entry
+	 * @return The calling thread's raw inflater
+	 */
+	static DatInflater& forThreadRaw() {
+		thread_local DatInflater inflater(-MAX_WBITS);
+		return inflater;
+	}
+
+	/**
+	 * Gets a stream ready to inflate a new stream, either setting it up or resetting it from its last use
+	 * @param Stream Where to put the stream
+	 * @return The result of setting up the stream (Z_OK if successful)
+	 */
+	int begin(z_stream*& Stream) {
+		int rc;
+		if (initialised) {
+			rc = inflateReset(&strm);
+		} else {
+			strm.zalloc = Z_NULL;
+			strm.zfree = Z_NULL;
+			strm.opaque = Z_NULL;
+			strm.avail_in = 0;
+			strm.next_in = Z_NULL;
+
+			rc = inflateInit2(&strm, windowBits);
+			initialised = rc == Z_OK;
+		}
+
+		Stream = &strm;
+		return rc;
+	}
+};
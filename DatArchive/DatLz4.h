@@ -0,0 +1,220 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * A compressor and decompressor for the LZ4 block format, so LZ4 entries don't need another library next to ZLib
+ * Output can be decompressed by any LZ4 block decoder (LZ4_decompress_safe), and this can decompress any LZ4 block
+ * The compressor is a greedy single probe hash chain, trading a little ratio for speed like LZ4's fast mode
+ */
+namespace DatLz4 {
+	static const size_t MINMATCH = 4;
+
+	// The last match has to start at least this many bytes before the end, and the last bytes are always literals
+	static const size_t MFLIMIT = 12;
+	static const size_t LASTLITERALS = 5;
+
+	static const size_t MAXOFFSET = 65535;
+	static const unsigned HASHBITS = 16;
+
+	/**
+	 * Gets the most bytes compressing a block can produce
+	 * @param InSize The size of the uncompressed block
+	 * @return The size to allocate for the compressed block
+	 */
+	inline size_t compressBound(size_t InSize) {
+		return InSize + InSize / 255 + 16;
+	}
+
+	inline uint32_t read32(const unsigned char* Ptr) {
+		uint32_t value;
+		memcpy(&value, Ptr, 4);
+		return value;
+	}
+
+	inline uint32_t hash(uint32_t Sequence) {
+		return (Sequence * 2654435761u) >> (32 - HASHBITS);
+	}
+
+	/**
+	 * Writes the rest of a length that didn't fit in its token nibble
+	 * @param Out Where to write, moved past what was written
+	 * @param Length The length beyond 15
+	 */
+	inline void writeLength(unsigned char*& Out, size_t Length) {
+		while (Length >= 255) {
+			*Out++ = 255;
+			Length -= 255;
+		}
+		*Out++ = (unsigned char) Length;
+	}
+
+	/**
+	 * Writes a sequence, some literals followed by a match (or just the literals for the last sequence)
+	 * @param Out Where to write, moved past what was written
+	 * @param Literals The literals
+	 * @param LiteralLength The amount of literals
+	 * @param Offset How far back the match is, unused for the last sequence
+	 * @param MatchLength The length of the match, 0 for the last sequence
+	 */
+	inline void writeSequence(unsigned char*& Out, const unsigned char* Literals, size_t LiteralLength, size_t Offset, size_t MatchLength) {
+		unsigned char* token = Out++;
+		*token = (unsigned char) ((LiteralLength >= 15 ? 15 : LiteralLength) << 4);
+		if (LiteralLength >= 15) writeLength(Out, LiteralLength - 15);
+
+		memcpy(Out, Literals, LiteralLength);
+		Out += LiteralLength;
+
+		if (MatchLength == 0) return;
+
+		*Out++ = (unsigned char) (Offset & 0xFF);
+		*Out++ = (unsigned char) (Offset >> 8);
+
+		size_t length = MatchLength - MINMATCH;
+		*token |= (unsigned char) (length >= 15 ? 15 : length);
+		if (length >= 15) writeLength(Out, length - 15);
+	}
+
+	/**
+	 * Compresses a block
+	 * @param In The uncompressed block
+	 * @param InSize The size of the uncompressed block, must be less than 4GB
+	 * @param Out The buffer for the compressed block, at least compressBound(InSize) bytes
+	 * @return The size of the compressed block
+	 */
+	inline size_t compress(const char* In, size_t InSize, char* Out) {
+		const unsigned char* in = reinterpret_cast<const unsigned char*>(In);
+		unsigned char* out = reinterpret_cast<unsigned char*>(Out);
+
+		size_t anchor = 0;
+
+		if (InSize > MFLIMIT) {
+			// Positions are stored plus one, so zero means empty
+			thread_local std::vector<uint32_t> table;
+			table.assign((size_t) 1 << HASHBITS, 0);
+
+			size_t matchLimit = InSize - LASTLITERALS;
+			size_t lastMatchStart = InSize - MFLIMIT;
+			size_t ip = 0;
+			size_t misses = 0;
+
+			while (ip < lastMatchStart) {
+				uint32_t sequence = read32(in + ip);
+				uint32_t& slot = table[hash(sequence)];
+				size_t ref = slot;
+				slot = (uint32_t) ip + 1;
+
+				if (ref == 0 || ip - (ref - 1) > MAXOFFSET || read32(in + ref - 1) != sequence) {
+					// Skip faster through data that isn't matching
+					ip += 1 + (misses++ >> 6);
+					continue;
+				}
+				ref -= 1;
+				misses = 0;
+
+				// Grow the match backwards into the literals, then forwards as far as it goes
+				while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+					--ip;
+					--ref;
+				}
+
+				size_t length = MINMATCH;
+				while (ip + length < matchLimit && in[ref + length] == in[ip + length]) ++length;
+
+				writeSequence(out, in + anchor, ip - anchor, ip - ref, length);
+				ip += length;
+				anchor = ip;
+
+				// Remember a position inside the match, so runs are picked up again straight away
+				if (ip < lastMatchStart) table[hash(read32(in + ip - 2))] = (uint32_t) (ip - 2) + 1;
+			}
+		}
+
+		writeSequence(out, in + anchor, InSize - anchor, 0, 0);
+		return (size_t) (out - reinterpret_cast<unsigned char*>(Out));
+	}
+
+	/**
+	 * Decompresses a block, checking every length and offset so bad data can't write or read out of bounds
+	 * @param In The compressed block
+	 * @param InSize The size of the compressed block
+	 * @param Out The buffer for the uncompressed block
+	 * @param OutSize The size of the uncompressed block
+	 * @return Whether the block decompressed to exactly OutSize bytes
+	 */
+	inline bool decompress(const char* In, size_t InSize, char* Out, size_t OutSize) {
+		const unsigned char* ip = reinterpret_cast<const unsigned char*>(In);
+		const unsigned char* inEnd = ip + InSize;
+		unsigned char* op = reinterpret_cast<unsigned char*>(Out);
+		unsigned char* outStart = op;
+		unsigned char* outEnd = op + OutSize;
+
+		while (ip < inEnd) {
+			unsigned token = *ip++;
+
+			// Literals
+			size_t length = token >> 4;
+			if (length == 15) {
+				unsigned char byte;
+				do {
+					if (ip >= inEnd) return false;
+					byte = *ip++;
+					length += byte;
+				} while (byte == 255);
+			}
+
+			if (length > (size_t) (inEnd - ip) || length > (size_t) (outEnd - op)) return false;
+
+			// Short runs are copied as a fixed 16 bytes when there's room, which is much quicker than a sized copy
+			if (length <= 16 && inEnd - ip >= 16 && outEnd - op >= 16) {
+				memcpy(op, ip, 16);
+			} else {
+				memcpy(op, ip, length);
+			}
+			ip += length;
+			op += length;
+
+			// The last sequence is only literals
+			if (ip == inEnd) break;
+
+			// Match
+			if (inEnd - ip < 2) return false;
+			size_t offset = (size_t) ip[0] | ((size_t) ip[1] << 8);
+			ip += 2;
+			if (offset == 0 || offset > (size_t) (op - outStart)) return false;
+
+			length = token & 15;
+			if (length == 15) {
+				unsigned char byte;
+				do {
+					if (ip >= inEnd) return false;
+					byte = *ip++;
+					length += byte;
+				} while (byte == 255);
+			}
+			length += MINMATCH;
+
+			if (length > (size_t) (outEnd - op)) return false;
+
+			const unsigned char* match = op - offset;
+			unsigned char* matchEnd = op + length;
+			if (offset >= 8 && (size_t) (outEnd - op) >= length + 8) {
+				// Copy 8 bytes at a time, possibly past the end of the match into space that is written later anyway
+				// Each copy only reads bytes at least 8 behind, so overlapping matches still repeat correctly
+				while (op < matchEnd) {
+					memcpy(op, match, 8);
+					op += 8;
+					match += 8;
+				}
+				op = matchEnd;
+			} else {
+				// Overlapping matches repeat the bytes they've just written
+				while (op < matchEnd) *op++ = *match++;
+			}
+		}
+
+		return op == outEnd;
+	}
+}
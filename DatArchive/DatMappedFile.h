@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * A read only memory mapping of a whole file
+ */
+class DatMappedFile {
+	const std::byte* mappedData = nullptr;
+	size_t mappedSize = 0;
+
+#ifdef _WIN32
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+	HANDLE mappingHandle = nullptr;
+#endif
+
+public:
+	DatMappedFile() = default;
+
+	DatMappedFile(const DatMappedFile&) = delete;
+	DatMappedFile& operator=(const DatMappedFile&) = delete;
+
+	~DatMappedFile() {
+		close();
+	}
+
+	/**
+	 * Maps the file at the given path into memory, unmapping anything that was previously mapped
+	 * @param Path The path to the file to map
+	 * @return Whether the file was successfully mapped
+	 */
+	bool open(const std::filesystem::path& Path) {
+		close();
+
+#ifdef _WIN32
+		fileHandle = CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+			close();
+			return false;
+		}
+
+		mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr) {
+			close();
+			return false;
+		}
+
+		void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr) {
+			close();
+			return false;
+		}
+
+		mappedData = static_cast<const std::byte*>(view);
+		mappedSize = (size_t) fileSize.QuadPart;
+#else
+		int fd = ::open(Path.c_str(), O_RDONLY);
+		if (fd == -1) return false;
+
+		struct stat fileStat{};
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+
+		void* view = mmap(nullptr, (size_t) fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+		// The mapping keeps its own reference to the file, so the descriptor isn't needed anymore
+		::close(fd);
+		if (view == MAP_FAILED) return false;
+
+		mappedData = static_cast<const std::byte*>(view);
+		mappedSize = (size_t) fileStat.st_size;
+#endif
+		return true;
+	}
+
+	/**
+	 * Unmaps the file, invalidating any pointers into the mapping
+	 */
+	void close() {
+#ifdef _WIN32
+		if (mappedData) UnmapViewOfFile(mappedData);
+		if (mappingHandle) CloseHandle(mappingHandle);
+		if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+		mappingHandle = nullptr;
+		fileHandle = INVALID_HANDLE_VALUE;
+#else
+		if (mappedData) munmap(const_cast<std::byte*>(mappedData), mappedSize);
+#endif
+		mappedData = nullptr;
+		mappedSize = 0;
+	}
+
+	/**
+	 * Checks if a file is currently mapped
+	 * @return Whether a file is mapped
+	 */
+	[[nodiscard]] bool isOpen() const {
+		return mappedData != nullptr;
+	}
+
+	/**
+	 * Gets a pointer to the start of the mapping
+	 * @return A pointer to the first byte of the file, or nullptr if nothing is mapped
+	 */
+	[[nodiscard]] const std::byte* data() const {
+		return mappedData;
+	}
+
+	/**
+	 * Gets the size of the mapping
+	 * @return The size of the mapped file in bytes
+	 */
+	[[nodiscard]] size_t size() const {
+		return mappedSize;
+	}
+
+	/**
+	 * Checks if the given range lies entirely inside the mapping
+	 * @param Offset The offset of the first byte of the range
+	 * @param Length The amount of bytes in the range
+	 * @return Whether the range can be safely read from the mapping
+	 */
+	[[nodiscard]] bool containsRange(int64_t Offset, int64_t Length) const {
+		return Offset >= 0 && Length >= 0 && (uint64_t) Offset <= mappedSize && (uint64_t) Length <= mappedSize - (uint64_t) Offset;
+	}
+};
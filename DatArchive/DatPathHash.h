@@ -0,0 +1,152 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * The minimal perfect hash stored in version 4 archives, mapping every path in the archive to a distinct slot with one hash and no probing
+ * Paths are spread into buckets, and each bucket stores a seed that sends all of its paths to free slots
+ * A seed with the top bit set is a bucket with a single path, the rest of the seed is the slot itself
+ */
+namespace DatPathHash {
+	static const uint32_t DIRECTSLOT = 0x80000000u;
+
+	// How many seeds to try for a bucket before giving up on building the hash
+	static const uint32_t MAXSEED = 1u << 24;
+
+	/**
+	 * Hashes a path, this must never change as it is baked into archives
+	 * @param Path The path to hash
+	 * @return The 64 bit hash of the path
+	 */
+	inline uint64_t hash(std::string_view Path) {
+		// FNV-1a
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (char c : Path) {
+			hash ^= (uint8_t) c;
+			hash *= 0x100000001B3ull;
+		}
+
+		// Finalise so both halves are well mixed
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	/**
+	 * Gets the bucket for a hash
+	 * @param Hash The hash of the path
+	 * @param BucketCount The amount of buckets
+	 * @return The index of the bucket
+	 */
+	inline uint32_t bucket(uint64_t Hash, uint32_t BucketCount) {
+		return (uint32_t) ((Hash >> 32) % BucketCount);
+	}
+
+	/**
+	 * Gets the slot for a hash with the given bucket seed
+	 * @param Hash The hash of the path
+	 * @param Seed The seed stored for the path's bucket
+	 * @param SlotCount The amount of slots, one per path
+	 * @return The index of the slot
+	 */
+	inline uint32_t slot(uint64_t Hash, uint32_t Seed, uint32_t SlotCount) {
+		if (Seed & DIRECTSLOT) return Seed & ~DIRECTSLOT;
+
+		uint64_t mixed = Hash ^ ((uint64_t) Seed * 0x9E3779B97F4A7C15ull);
+		mixed ^= mixed >> 31;
+		mixed *= 0xBF58476D1CE4E5B9ull;
+		mixed ^= mixed >> 29;
+		return (uint32_t) (mixed % SlotCount);
+	}
+
+	/**
+	 * Works out the amount of buckets to use for an amount of paths
+	 * @param PathCount The amount of paths
+	 * @return The amount of buckets
+	 */
+	inline uint32_t bucketCountFor(uint32_t PathCount) {
+		return std::max(1u, PathCount / 4);
+	}
+
+	/**
+	 * Builds the perfect hash for a set of paths
+	 * @param Hashes The hash of each path
+	 * @param Seeds Where to put the seed for each bucket
+	 * @param Slots Where to put the index of the path in each slot
+	 * @return Whether the hash was built, this fails if two paths have the same 64 bit hash
+	 */
+	inline bool build(const std::vector<uint64_t>& Hashes, std::vector<uint32_t>& Seeds, std::vector<uint32_t>& Slots) {
+		uint32_t count = (uint32_t) Hashes.size();
+		if (count == 0 || count >= DIRECTSLOT) return false;
+
+		// Paths with the same hash can never be separated
+		std::vector<uint64_t> sorted(Hashes);
+		std::sort(sorted.begin(), sorted.end());
+		if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) return false;
+
+		uint32_t bucketCount = bucketCountFor(count);
+		Seeds.assign(bucketCount, 0);
+		Slots.assign(count, UINT32_MAX);
+
+		// Group the paths by bucket
+		std::vector<std::vector<uint32_t>> buckets(bucketCount);
+		for (uint32_t i = 0; i < count; ++i) {
+			buckets[bucket(Hashes[i], bucketCount)].push_back(i);
+		}
+
+		// Place the biggest buckets first, while most slots are still free
+		std::vector<uint32_t> order(bucketCount);
+		for (uint32_t i = 0; i < bucketCount; ++i) order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t A, uint32_t B) {
+			return buckets[A].size() > buckets[B].size();
+		});
+
+		std::vector<uint32_t> placed;
+		uint32_t nextFree = 0;
+		for (uint32_t bucketIndex : order) {
+			const std::vector<uint32_t>& paths = buckets[bucketIndex];
+			if (paths.empty()) break;
+
+			// Single paths go straight into the next free slot
+			if (paths.size() == 1) {
+				while (Slots[nextFree] != UINT32_MAX) ++nextFree;
+				Slots[nextFree] = paths[0];
+				Seeds[bucketIndex] = DIRECTSLOT | nextFree;
+				continue;
+			}
+
+			// Find a seed that puts every path in the bucket into a different free slot
+			bool found = false;
+			for (uint32_t seed = 0; seed < MAXSEED && !found; ++seed) {
+				placed.clear();
+				found = true;
+
+				for (uint32_t path : paths) {
+					uint32_t target = slot(Hashes[path], seed, count);
+					if (Slots[target] != UINT32_MAX) {
+						found = false;
+						break;
+					}
+
+					Slots[target] = path;
+					placed.push_back(target);
+				}
+
+				if (found) {
+					Seeds[bucketIndex] = seed;
+				} else {
+					for (uint32_t target : placed) Slots[target] = UINT32_MAX;
+				}
+			}
+
+			if (!found) return false;
+		}
+
+		return true;
+	}
+}
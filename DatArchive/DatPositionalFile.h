@@ -0,0 +1,221 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/**
+ * A piece of a vectored read, Length bytes go to Buffer, or are skipped over if Buffer is nullptr
+ */
+struct DatReadSlice {
+	char* buffer = nullptr;
+	size_t length = 0;
+};
+
+/**
+ * A read only file that is read at explicit offsets instead of through a shared cursor
+ * Any number of threads can call readAt at the same time
+ */
+class DatPositionalFile {
+#ifdef _WIN32
+	HANDLE fileHandle = INVALID_HANDLE_VALUE;
+#else
+	int fd = -1;
+#endif
+
+public:
+	DatPositionalFile() = default;
+
+	DatPositionalFile(const DatPositionalFile&) = delete;
+	DatPositionalFile& operator=(const DatPositionalFile&) = delete;
+
+	~DatPositionalFile() {
+		close();
+	}
+
+	/**
+	 * Opens the file at the given path for reading, closing anything that was previously open
+	 * @param Path The path to the file to open
+	 * @return Whether the file was successfully opened
+	 */
+	bool open(const std::filesystem::path& Path) {
+		close();
+
+#ifdef _WIN32
+		fileHandle = CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		return fileHandle != INVALID_HANDLE_VALUE;
+#else
+		fd = ::open(Path.c_str(), O_RDONLY);
+		return fd != -1;
+#endif
+	}
+
+	/**
+	 * Closes the file
+	 */
+	void close() {
+#ifdef _WIN32
+		if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+#else
+		if (fd != -1) ::close(fd);
+		fd = -1;
+#endif
+	}
+
+	/**
+	 * Checks if a file is currently open
+	 * @return Whether a file is open
+	 */
+	[[nodiscard]] bool isOpen() const {
+#ifdef _WIN32
+		return fileHandle != INVALID_HANDLE_VALUE;
+#else
+		return fd != -1;
+#endif
+	}
+
+#ifndef _WIN32
+	/**
+	 * Gets the file descriptor, so reads can be handed to the kernel directly
+	 * @return The file descriptor, or -1 if no file is open
+	 */
+	[[nodiscard]] int descriptor() const {
+		return fd;
+	}
+#endif
+
+	/**
+	 * Gets the size of the open file
+	 * @return The size of the file in bytes, or -1 if it couldn't be found
+	 */
+	[[nodiscard]] int64_t size() const {
+#ifdef _WIN32
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize)) return -1;
+		return fileSize.QuadPart;
+#else
+		struct stat fileStat{};
+		if (fstat(fd, &fileStat) != 0) return -1;
+		return fileStat.st_size;
+#endif
+	}
+
+	/**
+	 * Reads the given amount of bytes starting at the given offset, without touching any shared file position
+	 * @param Offset The offset in the file of the first byte to read
+	 * @param Buffer The buffer to read into (assumed to be big enough for Length bytes)
+	 * @param Length The amount of bytes to read
+	 * @return Whether all of the bytes were read
+	 */
+	bool readAt(int64_t Offset, char* Buffer, size_t Length) const {
+		if (Offset < 0) return false;
+
+		while (Length > 0) {
+#ifdef _WIN32
+			// ReadFile can only take 32 bits worth of length at a time
+			DWORD toRead = Length > 0x80000000u ? 0x80000000u : (DWORD) Length;
+			DWORD bytesRead = 0;
+
+			OVERLAPPED overlapped{};
+			overlapped.Offset = (DWORD) ((uint64_t) Offset & 0xFFFFFFFFu);
+			overlapped.OffsetHigh = (DWORD) ((uint64_t) Offset >> 32);
+
+			if (!ReadFile(fileHandle, Buffer, toRead, &bytesRead, &overlapped) || bytesRead == 0) return false;
+#else
+			ssize_t bytesRead = pread(fd, Buffer, Length, (off_t) Offset);
+			if (bytesRead == -1 && errno == EINTR) continue;
+			if (bytesRead <= 0) return false;
+#endif
+			Buffer += bytesRead;
+			Offset += bytesRead;
+			Length -= (size_t) bytesRead;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Reads a run of bytes starting at the given offset into many buffers at once, without touching any shared file position
+	 * Lets reads of neighbouring data be merged into one request, skipping whatever is between them
+	 * @param Offset The offset in the file of the first byte of the first slice
+	 * @param Slices Where each part of the run goes, one after the other
+	 * @param Count The amount of slices
+	 * @return Whether all of the bytes were read
+	 */
+	bool readVectorAt(int64_t Offset, const DatReadSlice* Slices, size_t Count) const {
+		if (Offset < 0) return false;
+
+#ifdef _WIN32
+		// There's no positional scatter read for normal files, so read the whole run and split it up
+		size_t total = 0;
+		for (size_t i = 0; i < Count; ++i) total += Slices[i].length;
+
+		std::vector<char> run(total);
+		if (!readAt(Offset, run.data(), total)) return false;
+
+		size_t position = 0;
+		for (size_t i = 0; i < Count; ++i) {
+			if (Slices[i].buffer != nullptr) memcpy(Slices[i].buffer, run.data() + position, Slices[i].length);
+			position += Slices[i].length;
+		}
+		return true;
+#else
+		// Skipped slices are all read into the same scratch buffer
+		size_t skipped = 0;
+		for (size_t i = 0; i < Count; ++i) {
+			if (Slices[i].buffer == nullptr) skipped = std::max(skipped, Slices[i].length);
+		}
+		std::vector<char> scratch(skipped);
+
+		std::vector<iovec> pieces;
+		pieces.reserve(Count);
+		for (size_t i = 0; i < Count; ++i) {
+			if (Slices[i].length == 0) continue;
+			pieces.push_back({Slices[i].buffer != nullptr ? Slices[i].buffer : scratch.data(), Slices[i].length});
+		}
+
+		size_t next = 0;
+		while (next < pieces.size()) {
+			int count = (int) std::min<size_t>(pieces.size() - next, IOV_MAX);
+			ssize_t bytesRead = preadv(fd, pieces.data() + next, count, (off_t) Offset);
+			if (bytesRead == -1 && errno == EINTR) continue;
+			if (bytesRead <= 0) return false;
+			Offset += bytesRead;
+
+			// Move past the pieces that were filled, a short read can leave one part filled
+			size_t remaining = (size_t) bytesRead;
+			while (remaining > 0) {
+				if (remaining >= pieces[next].iov_len) {
+					remaining -= pieces[next].iov_len;
+					++next;
+				} else {
+					pieces[next].iov_base = static_cast<char*>(pieces[next].iov_base) + remaining;
+					pieces[next].iov_len -= remaining;
+					remaining = 0;
+				}
+			}
+		}
+		return true;
+#endif
+	}
+};
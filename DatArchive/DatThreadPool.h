@@ -0,0 +1,254 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Counts outstanding tasks so a thread can wait for a batch of them to finish
+ */
+class DatTaskCounter {
+	std::atomic<size_t> remaining{0};
+	std::mutex mutex;
+	std::condition_variable finished;
+
+public:
+	/**
+	 * Adds to the amount of outstanding tasks
+	 * @param Count The amount of tasks that were added
+	 */
+	void add(size_t Count = 1) {
+		remaining.fetch_add(Count, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Marks one task as finished, waking any waiters if it was the last one
+	 */
+	void done() {
+		// Finish under the lock, so a waiter can't see zero and destroy the counter while it is still being notified
+		std::lock_guard<std::mutex> lock(mutex);
+		if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			finished.notify_all();
+		}
+	}
+
+	/**
+	 * Checks if all the tasks have finished, once this returns true the counter can be destroyed
+	 * @return Whether there are no outstanding tasks
+	 */
+	[[nodiscard]] bool isDone() {
+		if (remaining.load(std::memory_order_acquire) != 0) return false;
+
+		// Wait for the last done to let go of the lock
+		std::lock_guard<std::mutex> lock(mutex);
+		return true;
+	}
+
+	/**
+	 * Blocks for a short while, or until the tasks are finished
+	 * @param Timeout The longest time to block for
+	 */
+	void waitFor(std::chrono::microseconds Timeout) {
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait_for(lock, Timeout, [this] { return remaining.load(std::memory_order_acquire) == 0; });
+	}
+};
+
+/**
+ * A fixed size pool of worker threads, each with their own task queue
+ * Workers take the newest task from their own queue, and steal the oldest task from the other queues when theirs is empty
+ */
+class DatThreadPool {
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<size_t> queuedTasks{0};
+	std::atomic<size_t> nextQueue{0};
+	bool stopping = false;
+
+	struct WorkerIdentity {
+		const DatThreadPool* pool = nullptr;
+		size_t index = SIZE_MAX;
+	};
+
+	/**
+	 * Gets the identity of the calling thread, set once when a worker starts
+	 * @return The pool and queue index owned by the calling thread
+	 */
+	static WorkerIdentity& currentWorker() {
+		thread_local WorkerIdentity identity;
+		return identity;
+	}
+
+	/**
+	 * Gets the index of the queue owned by the calling thread for this pool
+	 * @return The index of the queue, or SIZE_MAX if the calling thread isn't one of this pool's workers
+	 */
+	[[nodiscard]] size_t ownQueueIndex() const {
+		const WorkerIdentity& identity = currentWorker();
+		return identity.pool == this ? identity.index : SIZE_MAX;
+	}
+
+	/**
+	 * Takes a task from the given queue, either end
+	 * @param Queue The queue to take from
+	 * @param Newest Whether to take the newest task instead of the oldest
+	 * @param Task Where to put the task
+	 * @return Whether a task was taken
+	 */
+	bool takeTask(WorkerQueue& Queue, bool Newest, std::function<void()>& Task) {
+		std::lock_guard<std::mutex> lock(Queue.mutex);
+		if (Queue.tasks.empty()) return false;
+
+		if (Newest) {
+			Task = std::move(Queue.tasks.back());
+			Queue.tasks.pop_back();
+		} else {
+			Task = std::move(Queue.tasks.front());
+			Queue.tasks.pop_front();
+		}
+
+		queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/**
+	 * Finds a task, first from the given queue and then by stealing from the others
+	 * @param Home The index of the queue to check first
+	 * @param Task Where to put the task
+	 * @return Whether a task was found
+	 */
+	bool findTask(size_t Home, std::function<void()>& Task) {
+		if (takeTask(*queues[Home], true, Task)) return true;
+
+		for (size_t i = 1; i < queues.size(); ++i) {
+			if (takeTask(*queues[(Home + i) % queues.size()], false, Task)) return true;
+		}
+
+		return false;
+	}
+
+	void workerLoop(size_t Index) {
+		currentWorker() = {this, Index};
+
+		std::function<void()> task;
+		while (true) {
+			if (findTask(Index, task)) {
+				task();
+				task = nullptr;
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [this] { return stopping || queuedTasks.load(std::memory_order_relaxed) != 0; });
+			if (stopping && queuedTasks.load(std::memory_order_relaxed) == 0) return;
+		}
+	}
+
+public:
+	/**
+	 * Starts the worker threads
+	 * @param ThreadCount The amount of workers, 0 uses the amount of hardware threads
+	 */
+	explicit DatThreadPool(size_t ThreadCount = 0) {
+		if (ThreadCount == 0) ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		for (size_t i = 0; i < ThreadCount; ++i) {
+			queues.push_back(std::make_unique<WorkerQueue>());
+		}
+		for (size_t i = 0; i < ThreadCount; ++i) {
+			workers.emplace_back(&DatThreadPool::workerLoop, this, i);
+		}
+	}
+
+	DatThreadPool(const DatThreadPool&) = delete;
+	DatThreadPool& operator=(const DatThreadPool&) = delete;
+
+	/**
+	 * Finishes all the queued tasks, then stops the worker threads
+	 */
+	~DatThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+	}
+
+	/**
+	 * Gets a pool shared by everything that doesn't provide its own, sized to the amount of hardware threads
+	 * @return The shared pool
+	 */
+	static DatThreadPool& getDefault() {
+		static DatThreadPool pool;
+		return pool;
+	}
+
+	/**
+	 * Gets the amount of worker threads in the pool
+	 * @return The amount of worker threads
+	 */
+	[[nodiscard]] size_t threadCount() const {
+		return workers.size();
+	}
+
+	/**
+	 * Queues a task to be run on one of the workers
+	 * Tasks queued from a worker go onto that worker's own queue, everything else is spread across the queues
+	 * @param Task The task to run
+	 */
+	void submit(std::function<void()> Task) {
+		size_t index = ownQueueIndex();
+		if (index == SIZE_MAX) index = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+		{
+			// Count the task under the sleep lock before it's visible, so the count never drops below zero and a worker can't miss the wakeup
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			queuedTasks.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queues[index]->mutex);
+			queues[index]->tasks.push_back(std::move(Task));
+		}
+		wake.notify_one();
+	}
+
+	/**
+	 * Blocks until the counter reaches zero, running queued tasks on the calling thread in the meantime
+	 * @param Counter The counter to wait on
+	 */
+	void wait(DatTaskCounter& Counter) {
+		size_t home = ownQueueIndex();
+		if (home == SIZE_MAX) home = 0;
+
+		std::function<void()> task;
+		while (!Counter.isDone()) {
+			if (findTask(home, task)) {
+				task();
+				task = nullptr;
+			} else {
+				Counter.waitFor(std::chrono::microseconds(500));
+			}
+		}
+	}
+};
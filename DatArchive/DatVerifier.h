@@ -0,0 +1,123 @@
+#pragma once
+#include <DatArchive/DatChecksum.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+// How often DatFile checks the data it reads against its checksum
+static const uint8_t DATVERIFYALWAYS = 0;
+static const uint8_t DATVERIFYFIRSTREAD = 1;
+static const uint8_t DATVERIFYSAMPLED = 2;
+static const uint8_t DATVERIFYOFF = 3;
+
+/**
+ * Describes data that didn't match its checksum, handed to the archive's integrity handler
+ */
+struct DatIntegrityError {
+	// The path to the file in the archive
+	std::string file;
+
+	// The block of the file that didn't match, or -1 if it was the whole file
+	int64_t block = -1;
+
+	// The checksum that was checked, one of the DATCHECKSUM values, a CRC32 is in the low 32 bits of expected and received
+	uint8_t checksum = DATCHECKSUMCRC32;
+	uint64_t expected = 0;
+	uint64_t received = 0;
+};
+
+using DatIntegrityHandler = std::function<void(const DatIntegrityError&)>;
+
+/**
+ * Decides which reads are checked against their checksums, remembering what has been verified so far
+ * Everything that can be checked on its own gets a slot, a bit per slot is kept for the first read policy
+ * Safe to use from any number of threads once the policy and slot count are set
+ */
+class DatVerifier {
+	uint8_t policy = DATVERIFYALWAYS;
+
+	// Sampled reads are checked when a random 32 bit number is below this
+	uint64_t sampleThreshold = 0;
+
+	std::unique_ptr<std::atomic<uint64_t>[]> verified;
+	uint64_t slotCount = 0;
+
+	/**
+	 * Gets a random 32 bit number from a generator owned by the calling thread
+	 */
+	static uint32_t nextRandom() {
+		thread_local uint64_t state = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+
+		// xorshift64*
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (uint32_t) ((state * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+
+public:
+	/**
+	 * Sets how often reads are checked, and forgets everything verified so far
+	 * @param Policy One of the DATVERIFY values
+	 * @param SampleRate The fraction of reads checked by DATVERIFYSAMPLED, from 0 to 1
+	 */
+	void setPolicy(uint8_t Policy, double SampleRate) {
+		policy = Policy;
+		SampleRate = SampleRate < 0 ? 0 : SampleRate > 1 ? 1 : SampleRate;
+		sampleThreshold = (uint64_t) (SampleRate * 4294967296.0);
+		reset(slotCount);
+	}
+
+	/**
+	 * Gets how often reads are checked
+	 * @return One of the DATVERIFY values
+	 */
+	[[nodiscard]] uint8_t getPolicy() const {
+		return policy;
+	}
+
+	/**
+	 * Forgets everything verified so far, making room for a new amount of slots
+	 * @param Slots The amount of things that can be verified
+	 */
+	void reset(uint64_t Slots) {
+		slotCount = Slots;
+		verified.reset();
+		if (policy != DATVERIFYFIRSTREAD || Slots == 0) return;
+
+		size_t words = (size_t) ((Slots + 63) / 64);
+		verified = std::make_unique<std::atomic<uint64_t>[]>(words);
+		for (size_t i = 0; i < words; ++i) verified[i].store(0, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Checks if a read should be checked
+	 * @param Slot The slot of what was read, slots past the end are always checked by the first read policy
+	 * @return Whether to check it
+	 */
+	[[nodiscard]] bool shouldVerify(uint64_t Slot) const {
+		switch (policy) {
+		case DATVERIFYOFF:
+			return false;
+		case DATVERIFYSAMPLED:
+			return nextRandom() < sampleThreshold;
+		case DATVERIFYFIRSTREAD:
+			return Slot >= slotCount || (verified[Slot / 64].load(std::memory_order_relaxed) & (1ull << (Slot % 64))) == 0;
+		default:
+			return true;
+		}
+	}
+
+	/**
+	 * Remembers that a slot matched its checksum, so the first read policy doesn't check it again
+	 * @param Slot The slot that was verified
+	 */
+	void markVerified(uint64_t Slot) {
+		if (policy != DATVERIFYFIRSTREAD || Slot >= slotCount) return;
+		verified[Slot / 64].fetch_or(1ull << (Slot % 64), std::memory_order_relaxed);
+	}
+};
@@ -1,25 +1,118 @@
 #pragma once
 
 #include <DatArchive/DatArchiveCommon.h>
+#include <DatArchive/DatCodec.h>
+#include <DatArchive/DatDictionary.h>
+#include <DatArchive/DatPathHash.h>
+#include <DatArchive/DatThreadPool.h>
+
+#include <iterator>
 
 class DatFileWriter {
+	/**
+	 * Collects written data in memory, so files can be packed on other threads before being added to the archive
+	 */
+	struct MemoryStream {
+		std::vector<char> data;
+
+		MemoryStream& write(const char* Data, std::streamsize Size) {
+			data.insert(data.end(), Data, Data + Size);
+			return *this;
+		}
+
+		[[nodiscard]] std::streamoff tellp() const {
+			return (std::streamoff) data.size();
+		}
+
+		explicit operator bool() const {
+			return true;
+		}
+	};
+
+	/**
+	 * A file packed into memory by writeFiles, waiting to be added to the archive
+	 */
+	struct PackedFile {
+		MemoryStream stored;
+		DatFileEntry entry;
+		bool success = false;
+		bool streamed = false;
+		bool solid = false;
+		DatTaskCounter pending;
+	};
+
+	/**
+	 * Small files waiting to be compressed together into a solid block, there is one for each filetype and codec
+	 */
+	struct PendingSolidBlock {
+		uint8_t fileType = 0;
+		uint8_t codec = 0;
+		std::vector<char> data;
+		std::vector<std::pair<std::string, DatFileEntry>> members;
+	};
+
+	// The default amount of uncompressed data in a solid block before it is compressed and written
+	static const int64_t SOLIDBLOCKSIZE = 256 * 1024;
+
+	// Files bigger than this aren't packed in memory by writeFiles, they're streamed into the archive in turn instead
+	static const int64_t PARALLELPACKLIMIT = 64 * 1024 * 1024;
+
+	// Files bigger than this are split into blocks, compressed ones have their blocks deflated in parallel
+	static const int64_t PARALLELDEFLATELIMIT = 8 * 1024 * 1024;
+
+	/**
+	 * Checks if a file should be split into blocks, either because it's big or because it was asked to be seekable
+	 * Compressed files are deflated in blocks, stored files just get a CRC32 per block so ranges of them can be checked on their own
+	 * Seekable files that fit in a single block gain nothing from it, so are written as normal
+	 * @param Descriptor The descriptor for the file
+	 * @param Size The size of the file in bytes
+	 * @return Whether to write the file in blocks
+	 */
+	static bool useBlocks(const FileDescriptor& Descriptor, int64_t Size) {
+		if (Descriptor.compressed && Descriptor.codec != DATCODECZLIB) return false;
+		return Size > PARALLELDEFLATELIMIT || (Descriptor.seekable && Size > DATFILEBLOCKSIZE);
+	}
+
 	std::ofstream* archiveFile = nullptr;
+	uint8_t version = DATFILEVERSION;
 	std::unordered_map<std::string, DatFileEntry> table;
 
+	// The block index for every entry split into blocks, only written in version 5 and later
+	std::vector<DatBlock> blocks;
+
+	// Every dictionary added to the archive and the filetype it is for, and the latest dictionary for each filetype as an index plus one (version 7 and later)
+	std::vector<std::pair<uint8_t, std::vector<char>>> dictionaries;
+	uint8_t dictionaryForType[64] = {};
+
+	// Compressed files no bigger than solidEntryLimit are grouped into solid blocks, 0 turns this off (version 8 and later)
+	int64_t solidEntryLimit = 0;
+	int64_t solidBlockSize = SOLIDBLOCKSIZE;
+	std::vector<PendingSolidBlock> pendingSolidBlocks;
+
+	// Every solid block written so far, as an entry describing where its compressed data is
+	std::vector<DatFileEntry> solidBlocks;
+
+	// The checksum every entry is given, anything but CRC32 needs version 9 or later
+	uint8_t checksumType = DATCHECKSUMCRC32;
+
 public:
 	/**
 	 * Creates the initial archive file
 	 * @param FilePath The path for the file to end up in
 	 * @param force Whether to overrite the path at FilePath if it exists
+	 * @param Version The format version to write, either DATFILEVERSION or 0x02 for readers that only understand version 2
 	 */
-	DatFileWriter(const std::string& FilePath, bool Force = true) {
+	DatFileWriter(const std::string& FilePath, bool Force = true, uint8_t Version = DATFILEVERSION) {
+		assert(Version >= DATFILEMINVERSION && Version <= DATFILEVERSION);
+		version = Version;
+
 		// Create the File
 		archiveFile = new std::ofstream;
 		createFile(*archiveFile, FilePath, Force, true);
 
 		// Write Header
 		archiveFile->write(DATFILESIGNATURE, 4);
-		archiveFile->write(reinterpret_cast<const char*>(&DATFILEVERSION), 1);
+		archiveFile->write(reinterpret_cast<const char*>(&version), 1);
 
 		// Reserve header
 		char empty[8] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
@@ -33,12 +126,14 @@ private:
 	/**
 	 * Compresses the data from one file stream and deposits it in the next one
 	 * @param Source A pointer to the stream to compress
-	 * @param Dest A pointer to the stream to put the compressed data into
-	 * @param CRC A reference to the a uint32_t to put the resulting CRC32 into
+	 * @param Dest A pointer to the stream to put the compressed data into, either the archive or a MemoryStream
+	 * @param Checksum The checksum to add the compressed data to
 	 * @param Level The ZLib compression level
+	 * @param Dictionary The preset dictionary to compress against, or nullptr for none
 	 * @result The result of the compression (Success is Z_OK)
 	 */
-	int compressFileToStream(std::ifstream* Source, std::ofstream* Dest, uint32_t& CRC, int Level) {
+	template<typename Stream>
+	static int compressFileToStream(std::ifstream* Source, Stream* Dest, DatChecksum& Checksum, int Level, const std::vector<char>* Dictionary = nullptr) {
 		// States
 		int rc, flushState;
 
@@ -48,15 +143,12 @@ private:
 		// Stream
 		z_stream strm;
 
-		// CRC32
-		CRC = crc32(0L, Z_NULL, 0);
-
 		// Buffers
-		unsigned char* in = new unsigned char[CHUNK];
-		unsigned char* out = new unsigned char[CHUNK];
+		std::vector<unsigned char> in(CHUNK);
+		std::vector<unsigned char> out(CHUNK);
 
 		// Difference
-		uint32_t diff;
+		std::streamoff diff;
 
 		// Setup stream
 		strm.zalloc = Z_NULL;
@@ -67,28 +159,31 @@ private:
 		rc = deflateInit(&strm, Level);
 		if (rc != Z_OK) return rc;
 
+		if (Dictionary != nullptr) {
+			rc = deflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(Dictionary->data()), (uInt) Dictionary->size());
+			if (rc != Z_OK) {
+				deflateEnd(&strm);
+				return rc;
+			}
+		}
+
 		do {
 			// Read in some data from the file
-			Source->read(reinterpret_cast<char*>(in), CHUNK);
+			Source->read(reinterpret_cast<char*>(in.data()), CHUNK);
 			strm.avail_in = Source->gcount();
 
-			// If there was no data read then somethings gone wrong, stop deflating, free memory, and return an error
+			// If there was no data read then somethings gone wrong, stop deflating and return an error
 			if (!Source) {
 				deflateEnd(&strm);
-				delete[](in);
-				in = nullptr;
-
-				delete[](out);
-				out = nullptr;
 				return Z_ERRNO;
 			}
 
 			flushState = Source->eof() ? Z_FINISH : Z_NO_FLUSH;
-			strm.next_in = in;
+			strm.next_in = in.data();
 
 			do {
 				strm.avail_out = CHUNK;
-				strm.next_out = out;
+				strm.next_out = out.data();
 
 				// Deflate the data
 				rc = deflate(&strm, flushState);
@@ -96,22 +191,17 @@ private:
 
 				have = CHUNK - strm.avail_out;
 
-				// Generate the CRC for that chunk
-				CRC = crc32(CRC, out, have);
+				// Add that chunk to the checksum
+				Checksum.update(out.data(), have);
 
 				// Write the data to the file, work out the amount of data written by taking the point in the file after writing and subtracting the point before
 				diff = Dest->tellp();
-				Dest->write(reinterpret_cast<char*>(out), have);
-				diff = ((uint32_t)Dest->tellp()) - diff;
+				Dest->write(reinterpret_cast<char*>(out.data()), have);
+				diff = ((std::streamoff) Dest->tellp()) - diff;
 
-				// If the amount of data written is less than the chunk size after decompression then somethings gone wrong, stop deflating, free memory, and return an error
-				if (diff != have || !Dest) {
+				// If the amount of data written is less than the chunk size after decompression then somethings gone wrong, stop deflating and return an error
+				if (diff != (std::streamoff) have || !*Dest) {
 					deflateEnd(&strm);
-					delete[](in);
-					in = nullptr;
-
-					delete[](out);
-					out = nullptr;
 					return Z_ERRNO;
 				}
 			} while (strm.avail_out == 0);
@@ -122,55 +212,502 @@ private:
 		// Successfully deflated, clean up
 		deflateEnd(&strm);
 
-		delete[](in);
-		in = nullptr;
-
-		delete[](out);
-		out = nullptr;
 		return Z_OK;
 	}
 
+	/**
+	 * Compresses the data from one file stream into the next as a run of chunks, for every codec but ZLib
+	 * Each chunk is its compressed size (4) followed by its data, chunks that don't shrink are stored as they are with DATFILECHUNKSTORED set in their size
+	 * @param Codec The codec to compress with
+	 * @param Source A pointer to the stream to compress
+	 * @param Dest A pointer to the stream to put the compressed data into, either the archive or a MemoryStream
+	 * @param Checksum The checksum to add the compressed data to
+	 * @param Level The compression level, Z_DEFAULT_COMPRESSION uses the codec's own default
+	 * @result The result of the compression (Success is Z_OK)
+	 */
+	template<typename Stream>
+	static int compressChunksToStream(const DatCodec& Codec, std::ifstream* Source, Stream* Dest, DatChecksum& Checksum, int Level) {
+		std::vector<char> in((size_t) DATFILEBLOCKSIZE);
+		std::vector<char> out(Codec.compressBound((size_t) DATFILEBLOCKSIZE));
+
+		while (true) {
+			Source->read(in.data(), (std::streamsize) in.size());
+			size_t have = (size_t) Source->gcount();
+			if (have == 0) break;
+
+			size_t compressedSize = Codec.compress(in.data(), have, out.data(), Level);
+
+			const char* chunk = out.data();
+			uint32_t chunkSize = (uint32_t) compressedSize;
+			if (compressedSize == 0 || compressedSize >= have) {
+				chunk = in.data();
+				compressedSize = have;
+				chunkSize = (uint32_t) have | DATFILECHUNKSTORED;
+			}
+
+			Dest->write(reinterpret_cast<const char*>(&chunkSize), 4);
+			Dest->write(chunk, (std::streamsize) compressedSize);
+			if (!*Dest) return Z_ERRNO;
+
+			Checksum.update(&chunkSize, 4);
+			Checksum.update(chunk, compressedSize);
+		}
+
+		return Source->bad() ? Z_ERRNO : Z_OK;
+	}
+
 	/**
 	 * Copies one stream into the next
 	 * @param Source A pointer to the stream to copy
-	 * @param Dest A pointer to the stream to put the data into
-	 * @param CRC A reference to the a uint32_t to put the resulting CRC32 into
+	 * @param Dest A pointer to the stream to put the data into, either the archive or a MemoryStream
+	 * @param Checksum The checksum to add the data to
 	 */
-	void fileToStream(std::ifstream* Source, std::ofstream* Dest, uint32_t& CRC) {
+	template<typename Stream>
+	static void fileToStream(std::ifstream* Source, Stream* Dest, DatChecksum& Checksum) {
 		// Amount left
-		unsigned have;
-
-		// CRC32
-		CRC = crc32(0L, Z_NULL, 0);
+		size_t have;
 
 		// Buffers
-		unsigned char* buffer = new unsigned char[CHUNK];
+		std::vector<char> buffer(CHUNK);
 
 		while (!Source->eof()) {
 			/*
 			 * We'd probably have enough memory for this anyway, but we'll chunk it anyway, just in case.
 			 */
 			 // Fill buffer
-			Source->read(reinterpret_cast<char*>(buffer), CHUNK);
-			have = Source->gcount();
+			Source->read(buffer.data(), (std::streamsize) buffer.size());
+			have = (size_t) Source->gcount();
 
-			// Generate CRC
-			CRC = crc32(CRC, buffer, have);
+			// Add to the checksum
+			Checksum.update(buffer.data(), have);
 
 			// Write to file
-			Dest->write(reinterpret_cast<char*>(buffer), have);
+			Dest->write(buffer.data(), (std::streamsize) have);
+		}
+	}
+
+	/**
+	 * Gets the codec a compressed file asks for, checking it can be used in this archive
+	 * @param Descriptor The descriptor for the file
+	 * @return The codec, or nullptr if it isn't built in or the archive's version can't store it
+	 */
+	[[nodiscard]] const DatCodec* codecFor(const FileDescriptor& Descriptor) const {
+		const DatCodec* codec = DatCodec::get(Descriptor.codec);
+		if (codec == nullptr) {
+			std::cout << "Compression codec " << (int) Descriptor.codec << " isn't supported by this build" << std::endl;
+			return nullptr;
+		}
+
+		if (Descriptor.codec != DATCODECZLIB && version < 0x06) {
+			std::cout << "The " << codec->name() << " codec can only be used in version 6 and later archives" << std::endl;
+			return nullptr;
+		}
+
+		return codec;
+	}
+
+	/**
+	 * Gets the dictionary a file would be compressed against, files split into blocks never use one
+	 * @param Descriptor The descriptor for the file
+	 * @return The dictionary's index plus one, or 0 if the file doesn't use one
+	 */
+	[[nodiscard]] uint8_t dictionaryFor(const FileDescriptor& Descriptor) const {
+		if (!Descriptor.compressed || Descriptor.codec != DATCODECZLIB || Descriptor.fileType >= 64) return 0;
+		return dictionaryForType[Descriptor.fileType];
+	}
+
+	/**
+	 * Checks a name fits in the archive, whose records only hold a single byte of name length
+	 * @param Name The path of the file in the archive
+	 * @return Whether the name is short enough
+	 */
+	static bool checkName(const std::string& Name) {
+		if (Name.size() <= 255) return true;
+
+		std::cout << "The name \"" << Name << "\" is longer than 255 characters" << std::endl;
+		return false;
+	}
+
+	/**
+	 * Checks if a file should be grouped into a solid block
+	 * @param Descriptor The descriptor for the file
+	 * @param Size The size of the file in bytes
+	 * @param SolidEntryLimit The biggest file that goes in a solid block, 0 for none
+	 * @param Version The version of the archive being written, solid blocks need version 8 or later
+	 * @return Whether the file goes in a solid block
+	 */
+	static bool useSolidBlock(const FileDescriptor& Descriptor, int64_t Size, int64_t SolidEntryLimit, uint8_t Version) {
+		return Descriptor.compressed && SolidEntryLimit > 0 && Version >= 0x08 && Size <= SolidEntryLimit;
+	}
+
+	/**
+	 * Adds a file to the pending solid block for its filetype and codec, writing the block if it's full
+	 * @param Name The path of the file in the archive
+	 * @param Entry The entry for the file, with its filetype, size, and the crc of its uncompressed data
+	 * @param Codec The codec to compress the block with
+	 * @param Data The contents of the file
+	 * @return Whether the file was added, and the block written if it had to be
+	 */
+	bool addToSolidBlock(const std::string& Name, DatFileEntry Entry, uint8_t Codec, const std::vector<char>& Data) {
+		auto block = std::find_if(pendingSolidBlocks.begin(), pendingSolidBlocks.end(), [&](const PendingSolidBlock& It) {
+			return It.fileType == Entry.fileType && It.codec == Codec;
+		});
+		if (block == pendingSolidBlocks.end()) {
+			block = pendingSolidBlocks.emplace(pendingSolidBlocks.end());
+			block->fileType = Entry.fileType;
+			block->codec = Codec;
+		}
+
+		Entry.flags.compressed = true;
+		Entry.codec = Codec;
+		Entry.dataStart = (int64_t) block->data.size();
+		Entry.dataEnd = Entry.dataStart + (int64_t) Data.size() - 1;
+
+		block->data.insert(block->data.end(), Data.begin(), Data.end());
+		block->members.emplace_back(Name, Entry);
+
+		if ((int64_t) block->data.size() < solidBlockSize) return true;
+
+		bool success = writeSolidBlock(*block);
+		pendingSolidBlocks.erase(block);
+		return success;
+	}
+
+	/**
+	 * Compresses a solid block into the archive, and adds its files to the table
+	 * ZLib blocks are a single zlib stream, blocks using other codecs are a run of chunks like any other entry
+	 * If the block can't be written none of its files are added, and each of them is reported
+	 * @param Block The block to write
+	 * @return Whether the block was written
+	 */
+	bool writeSolidBlock(PendingSolidBlock& Block) {
+		const DatCodec* codec = DatCodec::get(Block.codec);
+		std::vector<char> stored;
+
+		auto fail = [&Block](const char* Reason) {
+			std::cout << Reason << ", leaving out the " << Block.members.size() << " files in it:" << std::endl;
+			for (const auto& it : Block.members) {
+				std::cout << "    " << it.first << std::endl;
+			}
+			return false;
+		};
+
+		if (Block.codec == DATCODECZLIB) {
+			stored.resize(codec->compressBound(Block.data.size()));
+			size_t size = codec->compress(Block.data.data(), Block.data.size(), stored.data(), Z_DEFAULT_COMPRESSION);
+			if (size == 0) return fail("Failed to compress a solid block");
+			stored.resize(size);
+		} else {
+			std::vector<char> out(codec->compressBound((size_t) DATFILEBLOCKSIZE));
+			for (size_t offset = 0; offset < Block.data.size(); offset += (size_t) DATFILEBLOCKSIZE) {
+				size_t have = std::min(Block.data.size() - offset, (size_t) DATFILEBLOCKSIZE);
+				size_t compressedSize = codec->compress(Block.data.data() + offset, have, out.data(), Z_DEFAULT_COMPRESSION);
+
+				// Chunks that don't shrink are stored as they are
+				const char* chunk = out.data();
+				uint32_t chunkSize = (uint32_t) compressedSize;
+				if (compressedSize == 0 || compressedSize >= have) {
+					chunk = Block.data.data() + offset;
+					compressedSize = have;
+					chunkSize = (uint32_t) have | DATFILECHUNKSTORED;
+				}
+
+				stored.insert(stored.end(), reinterpret_cast<const char*>(&chunkSize), reinterpret_cast<const char*>(&chunkSize) + 4);
+				stored.insert(stored.end(), chunk, chunk + compressedSize);
+			}
+		}
+
+		DatFileEntry blockEntry;
+		blockEntry.flags.compressed = true;
+		blockEntry.codec = Block.codec;
+		blockEntry.dataSize = (int64_t) Block.data.size();
+		blockEntry.crc = DatCrc32::compute(0, stored.data(), stored.size());
+
+		blockEntry.dataStart = archiveFile->tellp();
+		archiveFile->write(stored.data(), (std::streamsize) stored.size());
+		blockEntry.dataEnd = ((int64_t) archiveFile->tellp()) - 1;
+
+		// Flushed so a failed write is noticed here, while it is still known which files it drops
+		if (!archiveFile->flush()) return fail("Failed to write a solid block");
+
+		solidBlocks.push_back(blockEntry);
+		for (auto& it : Block.members) {
+			it.second.solidBlock = (uint32_t) solidBlocks.size();
+			table[it.first] = it.second;
 		}
+
+		return true;
+	}
+
+	/**
+	 * Deflates one block of a file on its own, as raw deflate data that can be joined onto the blocks before it
+	 * Every block but the last ends with a sync flush, so the next block starts on a byte boundary, the last one ends the deflate stream
+	 * @param In The uncompressed block
+	 * @param Out Where to put the deflated block
+	 * @param Last Whether this is the final block of the file
+	 * @param Level The ZLib compression level
+	 * @return The result of the compression (Success is Z_OK)
+	 */
+	static int deflateBlock(const std::vector<char>& In, std::vector<char>& Out, bool Last, int Level) {
+		z_stream strm;
+		strm.zalloc = Z_NULL;
+		strm.zfree = Z_NULL;
+		strm.opaque = Z_NULL;
+
+		// Raw deflate, the zlib header and trailer are written once around all of the blocks
+		int rc = deflateInit2(&strm, Level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+		if (rc != Z_OK) return rc;
+
+		// Room for the worst case, plus the empty stored block a sync flush ends with
+		Out.resize(deflateBound(&strm, (uLong) In.size()) + 16);
+
+		strm.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(In.data()));
+		strm.avail_in = (uInt) In.size();
+		strm.next_out = reinterpret_cast<unsigned char*>(Out.data());
+		strm.avail_out = (uInt) Out.size();
+
+		rc = deflate(&strm, Last ? Z_FINISH : Z_SYNC_FLUSH);
+		bool finished = Last ? rc == Z_STREAM_END : (rc == Z_OK && strm.avail_in == 0 && strm.avail_out != 0);
+
+		Out.resize(strm.total_out);
+		deflateEnd(&strm);
+		return finished ? Z_OK : Z_STREAM_ERROR;
+	}
+
+	/**
+	 * Compresses a file into the archive as a single zlib stream, deflating it in blocks of DATFILEBLOCKSIZE across the thread pool
+	 * Only a couple of blocks per thread are held in memory at a time
+	 * @param Source A pointer to the stream to compress
+	 * @param SourceSize The size of the file in bytes
+	 * @param Entry The entry for the file, gets its checksum and, from version 5, its blocks
+	 * @param Level The ZLib compression level
+	 * @param Pool The thread pool to deflate the blocks on
+	 * @return The result of the compression (Success is Z_OK)
+	 */
+	int compressBlocksToStream(std::ifstream* Source, int64_t SourceSize, DatFileEntry& Entry, int Level, DatThreadPool& Pool) {
+		int64_t blockTotal = (SourceSize + DATFILEBLOCKSIZE - 1) / DATFILEBLOCKSIZE;
+		size_t wave = Pool.threadCount() * 2;
+
+		std::vector<DatBlock> entryBlocks;
+		entryBlocks.reserve((size_t) blockTotal);
+
+		// The zlib header, the same one deflate would have written
+		int levelFlags = Level == Z_DEFAULT_COMPRESSION || Level == 6 ? 2 : Level < 2 ? 0 : Level < 6 ? 1 : 3;
+		unsigned header = (0x78 << 8) | (levelFlags << 6);
+		header += 31 - header % 31;
+		unsigned char zlibHeader[2] = {(unsigned char) (header >> 8), (unsigned char) (header & 0xFF)};
+
+		archiveFile->write(reinterpret_cast<char*>(zlibHeader), 2);
+		DatChecksum checksum(Entry.checksum);
+		checksum.update(zlibHeader, 2);
+		int64_t written = 2;
+
+		uLong adler = adler32(0L, Z_NULL, 0);
+
+		std::vector<std::vector<char>> in(wave);
+		std::vector<std::vector<char>> out(wave);
+		std::vector<uLong> adlers(wave);
+		std::vector<int> results(wave);
+
+		for (int64_t first = 0; first < blockTotal; first += (int64_t) wave) {
+			size_t count = (size_t) std::min<int64_t>((int64_t) wave, blockTotal - first);
+
+			// Read the blocks in order, then deflate them all at once
+			DatTaskCounter counter;
+			for (size_t i = 0; i < count; ++i) {
+				in[i].resize((size_t) std::min<int64_t>(DATFILEBLOCKSIZE, SourceSize - (first + (int64_t) i) * DATFILEBLOCKSIZE));
+				if (!Source->read(in[i].data(), (std::streamsize) in[i].size())) {
+					Pool.wait(counter);
+					return Z_ERRNO;
+				}
+
+				bool last = first + (int64_t) i == blockTotal - 1;
+				counter.add();
+				Pool.submit([&, i, last]() {
+					adlers[i] = adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const unsigned char*>(in[i].data()), (uInt) in[i].size());
+					results[i] = deflateBlock(in[i], out[i], last, Level);
+					counter.done();
+				});
+			}
+			Pool.wait(counter);
+
+			// Stitch them into the archive in order
+			for (size_t i = 0; i < count; ++i) {
+				if (results[i] != Z_OK) return results[i];
+
+				DatBlock block;
+				block.offset = written;
+				block.crc = DatCrc32::compute(0, out[i].data(), out[i].size());
+				entryBlocks.push_back(block);
+
+				archiveFile->write(out[i].data(), (std::streamsize) out[i].size());
+				if (!*archiveFile) return Z_ERRNO;
+
+				checksum.update(out[i].data(), out[i].size());
+				adler = adler32_combine(adler, adlers[i], (z_off_t) in[i].size());
+				written += (int64_t) out[i].size();
+			}
+		}
+
+		// The zlib trailer, the adler32 of all the uncompressed data
+		unsigned char trailer[4] = {(unsigned char) (adler >> 24), (unsigned char) (adler >> 16), (unsigned char) (adler >> 8), (unsigned char) adler};
+		archiveFile->write(reinterpret_cast<char*>(trailer), 4);
+		checksum.update(trailer, 4);
+		Entry.setChecksum(checksum.digest());
+
+		// Record where the blocks are, so they can be found without inflating everything before them
+		if (version >= 0x05) {
+			Entry.firstBlock = (uint32_t) blocks.size();
+			Entry.blockCount = (uint32_t) entryBlocks.size();
+			blocks.insert(blocks.end(), entryBlocks.begin(), entryBlocks.end());
+		}
+
+		return Z_OK;
+	}
+
+	/**
+	 * Copies a file into the archive as it is, taking a CRC32 of every DATFILEBLOCKSIZE bytes for the block index
+	 * @param Source A pointer to the stream to copy
+	 * @param SourceSize The size of the file in bytes
+	 * @param Entry The entry for the file, gets its checksum and, from version 5, its blocks
+	 * @return Whether the whole file was copied
+	 */
+	bool storeBlocksToStream(std::ifstream* Source, int64_t SourceSize, DatFileEntry& Entry) {
+		std::vector<DatBlock> entryBlocks;
+		entryBlocks.reserve((size_t) ((SourceSize + DATFILEBLOCKSIZE - 1) / DATFILEBLOCKSIZE));
+
+		DatChecksum checksum(Entry.checksum);
+		std::vector<char> buffer((size_t) std::min(SourceSize, DATFILEBLOCKSIZE));
+
+		for (int64_t offset = 0; offset < SourceSize; offset += DATFILEBLOCKSIZE) {
+			size_t length = (size_t) std::min(DATFILEBLOCKSIZE, SourceSize - offset);
+			if (!Source->read(buffer.data(), (std::streamsize) length)) return false;
+
+			DatBlock block;
+			block.offset = offset;
+			block.crc = DatCrc32::compute(0, buffer.data(), length);
+			entryBlocks.push_back(block);
+
+			checksum.update(buffer.data(), length);
+			archiveFile->write(buffer.data(), (std::streamsize) length);
+			if (!*archiveFile) return false;
+		}
+		Entry.setChecksum(checksum.digest());
+
+		if (version >= 0x05) {
+			Entry.firstBlock = (uint32_t) blocks.size();
+			Entry.blockCount = (uint32_t) entryBlocks.size();
+			blocks.insert(blocks.end(), entryBlocks.begin(), entryBlocks.end());
+		}
+
+		return true;
 	}
 
 public:
+	/**
+	 * Sets the checksum entries are checked against when they are read, this has to be done before any files are written
+	 * CRC32 is checked with the fastest kernel the CPU has, XXH64 is a 64 bit hash that makes corruption much less likely to go unnoticed
+	 * @param Type The checksum, one of the DATCHECKSUM values
+	 * @return Whether the checksum can be used, anything but CRC32 needs version 9 or later archives
+	 */
+	bool setChecksum(uint8_t Type) {
+		if (Type > DATCHECKSUMXXH64) return false;
+		if (Type != DATCHECKSUMCRC32 && version < 0x09) {
+			std::cout << "Checksums other than CRC32 can only be used in version 9 and later archives" << std::endl;
+			return false;
+		}
+		if (!table.empty() || !pendingSolidBlocks.empty()) {
+			std::cout << "The checksum can't be changed once files have been written" << std::endl;
+			return false;
+		}
+
+		checksumType = Type;
+		return true;
+	}
+
+	/**
+	 * Groups small compressed files of the same filetype and codec into solid blocks, compressed as one
+	 * Cuts down on the per file compression overhead, and on reads when lots of files from the same block are loaded together
+	 * @param MaxEntrySize The biggest file to put in a solid block, 0 stops files being put in solid blocks
+	 * @param BlockSize The amount of uncompressed data to collect in a block before it is written
+	 * @return Whether solid blocks can be used, they need version 8 or later archives
+	 */
+	bool setSolidBlocks(int64_t MaxEntrySize, int64_t BlockSize = SOLIDBLOCKSIZE) {
+		if (version < 0x08) {
+			std::cout << "Solid blocks can only be used in version 8 and later archives" << std::endl;
+			return false;
+		}
+		if (MaxEntrySize < 0 || BlockSize <= 0) return false;
+
+		solidEntryLimit = MaxEntrySize;
+		solidBlockSize = BlockSize;
+		return true;
+	}
+
+	/**
+	 * Sets the dictionary that compressed files of a filetype are compressed against from now on
+	 * Files already written keep the dictionary they were written with, and every dictionary is stored once in the table
+	 * @param FileType The filetype identifier the dictionary is for
+	 * @param Dictionary The dictionary, at most DatDictionary::MAXSIZE bytes are used
+	 * @return Whether the dictionary can be used, dictionaries need version 7 or later archives
+	 */
+	bool setDictionary(uint8_t FileType, std::vector<char> Dictionary) {
+		if (version < 0x07) {
+			std::cout << "Dictionaries can only be used in version 7 and later archives" << std::endl;
+			return false;
+		}
+		if (FileType >= 64 || Dictionary.empty() || dictionaries.size() >= 255) return false;
+
+		if (Dictionary.size() > DatDictionary::MAXSIZE) Dictionary.erase(Dictionary.begin(), Dictionary.end() - (std::ptrdiff_t) DatDictionary::MAXSIZE);
+
+		dictionaries.emplace_back(FileType, std::move(Dictionary));
+		dictionaryForType[FileType] = (uint8_t) dictionaries.size();
+		return true;
+	}
+
+	/**
+	 * Trains a dictionary for a filetype from sample files, then uses it for compressed files of that type from now on
+	 * Works best with lots of small files that share content, like shaders or scripts
+	 * @param FileType The filetype identifier the dictionary is for
+	 * @param SampleFiles The paths to the sample files on the disk, usually the files of that type about to be written
+	 * @return Whether a dictionary was trained and set, this fails if the samples don't have enough in common
+	 */
+	bool trainDictionary(uint8_t FileType, const std::vector<std::string>& SampleFiles) {
+		std::vector<std::vector<char>> samples;
+		samples.reserve(SampleFiles.size());
+
+		for (const std::string& file : SampleFiles) {
+			std::ifstream sample(file, std::ios::binary | std::ios::in);
+			if (!sample) {
+				std::cout << "Could not open the sample file " << file << std::endl;
+				return false;
+			}
+			samples.emplace_back(std::istreambuf_iterator<char>(sample), std::istreambuf_iterator<char>());
+		}
+
+		return setDictionary(FileType, DatDictionary::train(samples));
+	}
+
 	/**
 	 * Writes the data of a given file into the archive, treating it how the descriptor tells us to
 	 * @param File The path to the file on the disk
 	 * @param Descriptor A json object describing the file
+	 * @param Pool The thread pool to deflate big files on
 	 * @return Whether the file write was a success
 	 */
-	bool writeFile(const std::string& File, const FileDescriptor& Descriptor) {
+	bool writeFile(const std::string& File, const FileDescriptor& Descriptor, DatThreadPool& Pool = DatThreadPool::getDefault()) {
+		if (!checkName(Descriptor.destDirectory)) return false;
+
 		DatFileEntry entry;
+		entry.fileType = Descriptor.fileType & 0b00111111;
+		entry.checksum = checksumType;
+
+		// Check the codec before anything is written
+		const DatCodec* codec = nullptr;
+		if (Descriptor.compressed) {
+			codec = codecFor(Descriptor);
+			if (codec == nullptr) return false;
+		}
 
 		// Work out start
 		entry.dataStart = (archiveFile->tellp());
@@ -182,25 +719,62 @@ public:
 			return false;
 		}
 
+		// Get the size in bytes of the file we're adding to the archive
+		theFile.seekg(0, std::ios::end);
+		entry.dataSize = (theFile.tellg());
+		theFile.seekg(0, std::ios::beg);
+
+		// Small files are held back to be compressed together in a solid block
+		if (useSolidBlock(Descriptor, entry.dataSize, solidEntryLimit, version)) {
+			std::vector<char> data((size_t) entry.dataSize);
+			if (!theFile.read(data.data(), (std::streamsize) data.size())) {
+				std::cout << "Could not read the target file" << std::endl;
+				return false;
+			}
+
+			entry.setChecksum(DatChecksum::compute(checksumType, data.data(), data.size()));
+			return addToSolidBlock(Descriptor.destDirectory, entry, Descriptor.codec, data);
+		}
+
 		// Write data
 		if (Descriptor.compressed) {
 		    entry.flags.compressed = true;
+			entry.codec = Descriptor.codec;
+
+			// Big and seekable files are deflated in parallel blocks, everything else in one go
+			int rc;
+			DatChecksum checksum(checksumType);
+			if (Descriptor.codec != DATCODECZLIB) {
+				rc = compressChunksToStream(*codec, &theFile, archiveFile, checksum, Z_DEFAULT_COMPRESSION);
+				entry.setChecksum(checksum.digest());
+			} else if (useBlocks(Descriptor, entry.dataSize)) {
+				rc = compressBlocksToStream(&theFile, entry.dataSize, entry, Z_DEFAULT_COMPRESSION, Pool);
+			} else {
+				entry.dictionary = dictionaryFor(Descriptor);
+				const std::vector<char>* dictionary = entry.dictionary != 0 ? &dictionaries[entry.dictionary - 1].second : nullptr;
+				rc = compressFileToStream(&theFile, archiveFile, checksum, Z_DEFAULT_COMPRESSION, dictionary);
+				entry.setChecksum(checksum.digest());
+			}
 
 			// Return false if the file was not successfully compressed
-			if (compressFileToStream(&theFile, archiveFile, entry.crc, Z_DEFAULT_COMPRESSION) != Z_OK) {
+			if (rc != Z_OK) {
 				std::cout << "Failed to compress the file" << std::endl;
 				return false;
 			}
 		}
+		else if (useBlocks(Descriptor, entry.dataSize)) {
+			// Big and seekable stored files get a CRC32 per block, so parts of them can be read and checked
+			if (!storeBlocksToStream(&theFile, entry.dataSize, entry)) {
+				std::cout << "Could not read the target file" << std::endl;
+				return false;
+			}
+		}
 		else {
-			fileToStream(&theFile, archiveFile, entry.crc);
+			DatChecksum checksum(checksumType);
+			fileToStream(&theFile, archiveFile, checksum);
+			entry.setChecksum(checksum.digest());
 		}
 
-		// Get the size in bytes of the file we just added to the archive
-		theFile.clear();
-		theFile.seekg(0, std::ios::end);
-		entry.dataSize = (theFile.tellg());
-
 		// We're done with the file, close it
 		theFile.close();
 
@@ -216,13 +790,294 @@ public:
 	}
 
 	/**
-	 * Finishes the archive file, writing the filetable to the end
+	 * Writes the data of a list of files into the archive, compressing them across a thread pool
+	 * Files are added to the archive in the order they are listed, so the archive is the same no matter how many threads pack it
+	 * @param Files The path to each file on the disk, and the descriptor describing how to treat it
+	 * @param Pool The thread pool to pack the files on
+	 * @return Whether every file was written
 	 */
-	void finish() {
-		// Work out table offset
-		int64_t tableOffset = archiveFile->tellp();
+	bool writeFiles(const std::vector<std::pair<std::string, FileDescriptor>>& Files, DatThreadPool& Pool = DatThreadPool::getDefault()) {
+		std::vector<PackedFile> packed(Files.size());
+
+		// Only keep a few files per thread in memory at once
+		size_t window = Pool.threadCount() * 2;
+		size_t nextToPack = 0;
+		bool success = true;
+
+		for (size_t i = 0; i < Files.size(); ++i) {
+			for (; nextToPack < Files.size() && nextToPack < i + window; ++nextToPack) {
+				PackedFile& file = packed[nextToPack];
+				const auto& job = Files[nextToPack];
+
+				// Files with names that are too long, or asking for a codec that can't be used, are never packed
+				if (!checkName(job.second.destDirectory)) continue;
+				if (job.second.compressed && codecFor(job.second) == nullptr) continue;
+
+				uint8_t dictionary = dictionaryFor(job.second);
+				const std::vector<char>* dictionaryData = dictionary != 0 ? &dictionaries[dictionary - 1].second : nullptr;
+
+				file.pending.add();
+				Pool.submit([&file, &job, dictionary, dictionaryData, solidLimit = solidEntryLimit, archiveVersion = version, checksum = checksumType]() {
+					file.success = packFile(job.first, job.second, file, dictionary, dictionaryData, solidLimit, archiveVersion, checksum);
+					file.pending.done();
+				});
+			}
+
+			// Commit the files in order, running other packing tasks while this one isn't ready
+			PackedFile& file = packed[i];
+			Pool.wait(file.pending);
+
+			if (file.streamed) {
+				success = writeFile(Files[i].first, Files[i].second, Pool) && success;
+			} else if (file.success && file.solid) {
+				success = addToSolidBlock(Files[i].second.destDirectory, file.entry, Files[i].second.codec, file.stored.data) && success;
+			} else if (file.success) {
+				file.entry.dataStart = archiveFile->tellp();
+				archiveFile->write(file.stored.data.data(), (std::streamsize) file.stored.data.size());
+				file.entry.dataEnd = ((int64_t) archiveFile->tellp()) - 1;
+
+				table[Files[i].second.destDirectory] = file.entry;
+			} else {
+				success = false;
+			}
+
+			// Done with the data
+			file.stored.data = std::vector<char>();
+		}
+
+		archiveFile->flush();
+		return success;
+	}
+
+private:
+	/**
+	 * Packs a file into memory, ready for writeFiles to add to the archive
+	 * @param File The path to the file on the disk
+	 * @param Descriptor A json object describing the file
+	 * @param Packed Where to put the stored data and the entry for the file, the data start and end are left for the commit
+	 * @param Dictionary The dictionary to compress against as an index plus one, 0 for none
+	 * @param DictionaryData The contents of that dictionary
+	 * @param SolidEntryLimit The biggest file that goes in a solid block, 0 for none
+	 * @param Version The version of the archive being written
+	 * @param ChecksumType The checksum to give the file, one of the DATCHECKSUM values
+	 * @return Whether the file was packed, or left to be streamed because it is too big
+	 */
+	static bool packFile(const std::string& File, const FileDescriptor& Descriptor, PackedFile& Packed, uint8_t Dictionary, const std::vector<char>* DictionaryData, int64_t SolidEntryLimit, uint8_t Version, uint8_t ChecksumType) {
+		Packed.entry.fileType = Descriptor.fileType & 0b00111111;
+		Packed.entry.checksum = ChecksumType;
+		DatChecksum checksum(ChecksumType);
+
+		std::ifstream theFile(File, std::ios::binary | std::ios::in);
+		if (!theFile) {
+			std::cout << "Could not open the target file" << std::endl;
+			return false;
+		}
+
+		// Get the size in bytes of the file
+		theFile.seekg(0, std::ios::end);
+		Packed.entry.dataSize = theFile.tellg();
+		theFile.seekg(0, std::ios::beg);
+
+		// Files going in a solid block are just read in, they're compressed with the rest of the block
+		if (useSolidBlock(Descriptor, Packed.entry.dataSize, SolidEntryLimit, Version)) {
+			Packed.solid = true;
+			fileToStream(&theFile, &Packed.stored, checksum);
+			Packed.entry.setChecksum(checksum.digest());
+			return true;
+		}
+
+		// Big files are left to writeFile, as are files that are written in blocks
+		if (Packed.entry.dataSize > PARALLELPACKLIMIT || useBlocks(Descriptor, Packed.entry.dataSize)) {
+			Packed.streamed = true;
+			return true;
+		}
+
+		if (Descriptor.compressed) {
+			Packed.entry.flags.compressed = true;
+			Packed.entry.codec = Descriptor.codec;
+
+			int rc;
+			if (Descriptor.codec != DATCODECZLIB) {
+				rc = compressChunksToStream(*DatCodec::get(Descriptor.codec), &theFile, &Packed.stored, checksum, Z_DEFAULT_COMPRESSION);
+			} else {
+				Packed.entry.dictionary = Dictionary;
+				rc = compressFileToStream(&theFile, &Packed.stored, checksum, Z_DEFAULT_COMPRESSION, DictionaryData);
+			}
+
+			if (rc != Z_OK) {
+				std::cout << "Failed to compress the file" << std::endl;
+				return false;
+			}
+		}
+		else {
+			fileToStream(&theFile, &Packed.stored, checksum);
+		}
+
+		Packed.entry.setChecksum(checksum.digest());
+		return true;
+	}
+
+	/**
+	 * Writes the table in the version 3 layout, a fixed size record per entry sorted by name, followed by a pool of all the names
+	 */
+	void writeTableV3() {
+		// Sort the names so readers can binary search the records
+		std::vector<const std::pair<const std::string, DatFileEntry>*> entries;
+		entries.reserve(table.size());
+		for (auto& it : table) {
+			entries.push_back(&it);
+		}
+		std::sort(entries.begin(), entries.end(), [](const auto* A, const auto* B) {
+			return A->first < B->first;
+		});
+
+		uint64_t poolSize = 0;
+		for (auto* it : entries) {
+			poolSize += (uint8_t) it->first.size();
+		}
+
+		// Header
+		char header[DATFILETABLEHEADERSIZE] = {};
+		uint32_t count = (uint32_t) entries.size();
+		uint16_t recordSize = (uint16_t) getRecordSize(version);
+		memcpy(header, &count, 4);
+		memcpy(header + 4, &recordSize, 2);
+		if (version >= 0x09) {
+			uint16_t checksum = checksumType;
+			memcpy(header + 6, &checksum, 2);
+		}
+		memcpy(header + 8, &poolSize, 8);
+		archiveFile->write(header, DATFILETABLEHEADERSIZE);
 
+		// Records
+		char record[DATFILERECORDSIZE];
+		uint32_t nameOffset = 0;
+		for (auto* it : entries) {
+			uint8_t nameLength = (uint8_t) it->first.size();
+			it->second.writeRecord(record, nameOffset, nameLength);
+			archiveFile->write(record, recordSize);
+			nameOffset += nameLength;
+		}
+
+		// Name pool
+		for (auto* it : entries) {
+			archiveFile->write(it->first.c_str(), (uint8_t) it->first.size());
+		}
+
+		if (version >= 0x04) {
+			writeHashIndex(entries);
+		}
+
+		if (version >= 0x05) {
+			writeBlockIndex();
+		}
+
+		if (version >= 0x07) {
+			writeDictionaryIndex();
+		}
+
+		if (version >= 0x08) {
+			writeSolidIndex();
+		}
+	}
+
+	/**
+	 * Writes the solid index, where each solid block is and how to decompress it
+	 */
+	void writeSolidIndex() {
+		// Header, block count (4) and reserved (4)
+		char header[DATFILESOLIDHEADERSIZE] = {};
+		uint32_t count = (uint32_t) solidBlocks.size();
+		memcpy(header, &count, 4);
+		archiveFile->write(header, DATFILESOLIDHEADERSIZE);
 
+		// Blocks, uncompressed size (8), data start (8), data end (8), crc (4), codec (1), and reserved (3)
+		for (const DatFileEntry& it : solidBlocks) {
+			char block[DATFILESOLIDENTRYSIZE] = {};
+			memcpy(block, &it.dataSize, 8);
+			memcpy(block + 8, &it.dataStart, 8);
+			memcpy(block + 16, &it.dataEnd, 8);
+			memcpy(block + 24, &it.crc, 4);
+			block[28] = (char) it.codec;
+			archiveFile->write(block, DATFILESOLIDENTRYSIZE);
+		}
+	}
+
+	/**
+	 * Writes the dictionary index, every dictionary entries were compressed against
+	 */
+	void writeDictionaryIndex() {
+		// Header, dictionary count (4) and reserved (4)
+		char header[DATFILEDICTIONARYHEADERSIZE] = {};
+		uint32_t count = (uint32_t) dictionaries.size();
+		memcpy(header, &count, 4);
+		archiveFile->write(header, DATFILEDICTIONARYHEADERSIZE);
+
+		// Dictionaries, filetype (1), reserved (3), and size (4), followed by the dictionary itself
+		for (const auto& it : dictionaries) {
+			char entry[DATFILEDICTIONARYENTRYSIZE] = {};
+			uint32_t size = (uint32_t) it.second.size();
+			entry[0] = (char) it.first;
+			memcpy(entry + 4, &size, 4);
+			archiveFile->write(entry, DATFILEDICTIONARYENTRYSIZE);
+			archiveFile->write(it.second.data(), (std::streamsize) it.second.size());
+		}
+	}
+
+	/**
+	 * Writes the block index, where each block of the entries split into blocks starts, and its crc
+	 */
+	void writeBlockIndex() {
+		// Header, block size (4), reserved (4), and block count (8)
+		char header[DATFILEBLOCKHEADERSIZE] = {};
+		uint32_t blockSize = (uint32_t) DATFILEBLOCKSIZE;
+		uint64_t blockCount = blocks.size();
+		memcpy(header, &blockSize, 4);
+		memcpy(header + 8, &blockCount, 8);
+		archiveFile->write(header, DATFILEBLOCKHEADERSIZE);
+
+		// Blocks, offset from the start of the entry's data (8), crc (4), and reserved (4)
+		char block[DATFILEBLOCKENTRYSIZE] = {};
+		for (const DatBlock& it : blocks) {
+			memcpy(block, &it.offset, 8);
+			memcpy(block + 8, &it.crc, 4);
+			archiveFile->write(block, DATFILEBLOCKENTRYSIZE);
+		}
+	}
+
+	/**
+	 * Writes the perfect hash over the names, which maps each name straight to the index of its record
+	 * If the hash can't be built a bucket count of 0 is written, and readers fall back to a binary search
+	 * @param Entries The entries in the order their records were written
+	 */
+	void writeHashIndex(const std::vector<const std::pair<const std::string, DatFileEntry>*>& Entries) {
+		std::vector<uint64_t> hashes;
+		hashes.reserve(Entries.size());
+		for (auto* it : Entries) {
+			hashes.push_back(DatPathHash::hash(it->first));
+		}
+
+		std::vector<uint32_t> seeds;
+		std::vector<uint32_t> slots;
+		if (!DatPathHash::build(hashes, seeds, slots)) {
+			seeds.clear();
+			slots.clear();
+		}
+
+		// Header, bucket count (4) and reserved (4)
+		char header[DATFILEHASHHEADERSIZE] = {};
+		uint32_t bucketCount = (uint32_t) seeds.size();
+		memcpy(header, &bucketCount, 4);
+		archiveFile->write(header, DATFILEHASHHEADERSIZE);
+
+		archiveFile->write(reinterpret_cast<const char*>(seeds.data()), (std::streamsize) (seeds.size() * 4));
+		archiveFile->write(reinterpret_cast<const char*>(slots.data()), (std::streamsize) (slots.size() * 4));
+	}
+
+	/**
+	 * Writes the table in the version 2 layout, each entry's name followed by its details
+	 */
+	void writeTableV2() {
         uint8_t buffer;
 		// Add all table entries to the table
 		for (auto & it : table) {
@@ -249,6 +1104,38 @@ public:
 			// Data End
 			archiveFile->write(reinterpret_cast<char*>(&it.second.dataEnd), 8);
 		}
+	}
+
+public:
+	/**
+	 * Finishes the archive file, writing the filetable to the end
+	 * The archive is always finished, but files in a solid block that couldn't be written are left out of it
+	 * @return Whether every file added to the archive made it into the table, and the archive was written
+	 */
+	bool finish() {
+		bool success = true;
+
+		// Write the solid blocks that didn't fill up
+		for (PendingSolidBlock& it : pendingSolidBlocks) {
+			success = writeSolidBlock(it) && success;
+		}
+		pendingSolidBlocks.clear();
+
+		// Version 3 tables start on an 8 byte boundary so the records are aligned when the archive is memory mapped
+		if (version >= 0x03) {
+			char padding[8] = {};
+			int64_t position = archiveFile->tellp();
+			archiveFile->write(padding, (8 - position % 8) % 8);
+		}
+
+		// Work out table offset
+		int64_t tableOffset = archiveFile->tellp();
+
+		if (version >= 0x03) {
+			writeTableV3();
+		} else {
+			writeTableV2();
+		}
 
 		// Go to the table offset
 		archiveFile->seekp(5);
@@ -259,7 +1146,9 @@ public:
 		// Write and close the file
 		archiveFile->flush();
 		archiveFile->close();
+		success = success && !archiveFile->fail();
 		delete(archiveFile);
 		archiveFile = nullptr;
+		return success;
 	}
 };
\ No newline at end of file
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <DatArchive.h>
+
+#include <list>
+#include <unordered_map>
+
+// How urgently a scheduled read is needed, lower values are read first
+static const uint8_t DATPRIORITYVISIBLE = 0;
+static const uint8_t DATPRIORITYPREFETCH = 1;
+static const uint8_t DATPRIORITYBACKGROUND = 2;
+static const uint8_t DATPRIORITYCOUNT = 3;
+
+/**
+ * Identifies a read queued with a DatScheduler, 0 is never used
+ */
+using DatRequestId = uint64_t;
+
+/**
+ * Queues reads from an archive by priority, so urgent files aren't stuck behind ones that are only wanted eventually
+ * At most a fixed amount of reads run at once, each is read and decompressed whole before the next is started, always the most urgent one queued
+ * One of those runners is kept back for visible reads, so however many prefetches are queued a visible read waits for at most one read to finish
+ * Reads that haven't started can be cancelled or given a new priority, a read that has started always finishes
+ */
+class DatScheduler {
+	struct Request {
+		DatRequestId id = 0;
+		AssetHandle handle;
+		std::function<void(std::vector<char>&&)> callback;
+	};
+
+	using RequestList = std::list<Request>;
+
+	const DatFile& archive;
+	DatThreadPool& pool;
+	size_t concurrency;
+
+	// Reads below the visible priority can only use this many runners
+	size_t lowConcurrency;
+
+	mutable std::mutex mutex;
+	RequestList queues[DATPRIORITYCOUNT];
+	std::unordered_map<DatRequestId, std::pair<uint8_t, RequestList::iterator>> lookup;
+	DatRequestId nextId = 1;
+	size_t running = 0;
+	size_t lowRunning = 0;
+
+	// Counts the runners on the pool, so the scheduler can wait for them before it is destroyed
+	DatTaskCounter runners;
+
+	/**
+	 * Takes the most urgent request a runner is allowed to start, must be called with the mutex held
+	 * @param Taken Where to put the request
+	 * @param Priority Where to put its priority
+	 * @return Whether there was one
+	 */
+	bool takeNext(Request& Taken, uint8_t& Priority) {
+		for (uint8_t priority = 0; priority < DATPRIORITYCOUNT; ++priority) {
+			if (queues[priority].empty()) continue;
+			if (priority != DATPRIORITYVISIBLE && lowRunning >= lowConcurrency) return false;
+
+			Taken = std::move(queues[priority].front());
+			queues[priority].pop_front();
+			lookup.erase(Taken.id);
+			Priority = priority;
+			return true;
+		}
+
+		return false;
+	}
+
+	/**
+	 * Reads requests one at a time until there are none it is allowed to start
+	 */
+	void runLoop() {
+		std::unique_lock<std::mutex> lock(mutex);
+
+		Request request;
+		uint8_t priority;
+		while (takeNext(request, priority)) {
+			bool low = priority != DATPRIORITYVISIBLE;
+			if (low) ++lowRunning;
+			lock.unlock();
+
+			request.callback(archive.getFile(request.handle));
+			request = Request();
+
+			lock.lock();
+			if (low) --lowRunning;
+		}
+
+		--running;
+		lock.unlock();
+		runners.done();
+	}
+
+	/**
+	 * Starts another runner if there is room for one, must be called with the mutex held
+	 */
+	void startRunner() {
+		if (running >= concurrency) return;
+
+		++running;
+		runners.add();
+		pool.submit([this]() {
+			runLoop();
+		});
+	}
+
+public:
+	/**
+	 * Creates the scheduler
+	 * @param Archive The archive to read from, which must outlive the scheduler
+	 * @param Pool The thread pool to read and decompress files on, its threads are blocked while they read
+	 * @param Concurrency The most reads running at once, 0 uses the amount of threads in the pool
+	 */
+	explicit DatScheduler(const DatFile& Archive, DatThreadPool& Pool = DatThreadPool::getDefault(), size_t Concurrency = 0) : archive(Archive), pool(Pool) {
+		concurrency = Concurrency == 0 ? Pool.threadCount() : Concurrency;
+		lowConcurrency = concurrency > 1 ? concurrency - 1 : 1;
+	}
+
+	DatScheduler(const DatScheduler&) = delete;
+	DatScheduler& operator=(const DatScheduler&) = delete;
+
+	/**
+	 * Cancels every read that hasn't started, and waits for the rest to finish
+	 */
+	~DatScheduler() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto& queue : queues) queue.clear();
+			lookup.clear();
+		}
+		pool.wait(runners);
+	}
+
+	/**
+	 * Queues a file to be read
+	 * @param File The path to the file in the archive
+	 * @param Priority How urgently the file is needed, one of the DATPRIORITY values
+	 * @param Callback Called from the pool with the file's data once it has been read, which is empty if it couldn't be read, never called if the read is cancelled
+	 * @return The id of the request, or 0 if the file doesn't exist
+	 */
+	DatRequestId submit(std::string_view File, uint8_t Priority, std::function<void(std::vector<char>&&)> Callback) {
+		AssetHandle handle = archive.resolve(File);
+		if (!archive.isValid(handle)) {
+			std::cout << "Attempted to get file: " << File << ", but it doesn't exist" << std::endl;
+			return 0;
+		}
+
+		return submit(handle, Priority, std::move(Callback));
+	}
+
+	/**
+	 * Queues a file to be read, using a handle from resolve
+	 * @param Handle The handle to the file, from the scheduler's archive
+	 * @param Priority How urgently the file is needed, one of the DATPRIORITY values
+	 * @param Callback Called from the pool with the file's data once it has been read, which is empty if it couldn't be read, never called if the read is cancelled
+	 * @return The id of the request, or 0 if the handle is invalid
+	 */
+	DatRequestId submit(AssetHandle Handle, uint8_t Priority, std::function<void(std::vector<char>&&)> Callback) {
+		if (!archive.isValid(Handle)) {
+			std::cout << "Attempted to get a file with an invalid handle" << std::endl;
+			return 0;
+		}
+		if (Priority >= DATPRIORITYCOUNT) Priority = DATPRIORITYCOUNT - 1;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Request request;
+		request.id = nextId++;
+		request.handle = Handle;
+		request.callback = std::move(Callback);
+
+		RequestList& queue = queues[Priority];
+		queue.push_back(std::move(request));
+		lookup[queue.back().id] = {Priority, std::prev(queue.end())};
+
+		startRunner();
+		return queue.back().id;
+	}
+
+	/**
+	 * Cancels a read that hasn't started yet, its callback is never called
+	 * @param Id The id of the request
+	 * @return Whether it was cancelled, false if it has already started, finished, or been cancelled
+	 */
+	bool cancel(DatRequestId Id) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = lookup.find(Id);
+		if (it == lookup.end()) return false;
+
+		queues[it->second.first].erase(it->second.second);
+		lookup.erase(it);
+		return true;
+	}
+
+	/**
+	 * Gives a read that hasn't started yet a new priority, moving it to the back of that priority's queue
+	 * @param Id The id of the request
+	 * @param Priority How urgently the file is now needed, one of the DATPRIORITY values
+	 * @return Whether the priority was changed, false if it has already started, finished, or been cancelled
+	 */
+	bool reprioritise(DatRequestId Id, uint8_t Priority) {
+		if (Priority >= DATPRIORITYCOUNT) Priority = DATPRIORITYCOUNT - 1;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = lookup.find(Id);
+		if (it == lookup.end()) return false;
+
+		RequestList& from = queues[it->second.first];
+		RequestList& to = queues[Priority];
+		to.splice(to.end(), from, it->second.second);
+		it->second.first = Priority;
+
+		// A visible read may now be able to use the runner kept back for it
+		startRunner();
+		return true;
+	}
+
+	/**
+	 * Gets the amount of reads waiting to start
+	 * @param Priority The priority to count, or DATPRIORITYCOUNT to count all of them
+	 * @return The amount of queued reads
+	 */
+	[[nodiscard]] size_t queued(uint8_t Priority = DATPRIORITYCOUNT) const {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (Priority < DATPRIORITYCOUNT) return queues[Priority].size();
+		return lookup.size();
+	}
+
+	/**
+	 * Blocks until every read queued so far has finished, running queued pool tasks on the calling thread in the meantime
+	 */
+	void wait() {
+		pool.wait(runners);
+	}
+};
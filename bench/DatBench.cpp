@@ -0,0 +1,305 @@
+#include <DatArchiveWriter.h>
+#include <DatArchive.h>
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+
+/**
+ * Measures the hot paths of the library, each benchmark writes the archives it needs to a scratch directory first
+ * Run with the names of the benchmarks to run, or nothing to run all of them, from a release build
+ */
+
+static std::filesystem::path scratchDirectory;
+
+// Results that are only computed to be timed are written here, so the work isn't optimised away
+static volatile uint64_t resultSink;
+
+/**
+ * Times a piece of work
+ * @param Work The work to time
+ * @return How long it took in seconds
+ */
+template<typename Function>
+static double timeSeconds(Function&& Work) {
+	auto start = std::chrono::steady_clock::now();
+	Work();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Writes a file to the scratch directory, to be added to an archive
+ * @param Name The name of the file
+ * @param Data The contents of the file
+ * @return The path to the file
+ */
+static std::string writeSource(const std::string& Name, const std::string& Data) {
+	std::filesystem::path path = scratchDirectory / "source" / Name;
+	std::filesystem::create_directories(path.parent_path());
+	std::ofstream(path, std::ios::binary).write(Data.data(), (std::streamsize) Data.size());
+	return path.string();
+}
+
+/**
+ * Makes data that compresses about as well as typical game assets
+ * @param Size The amount of bytes
+ * @param Seed Varies the data
+ * @return The data
+ */
+static std::string makeData(size_t Size, uint32_t Seed) {
+	std::string data;
+	data.reserve(Size + 16);
+
+	uint32_t state = Seed * 2654435761u + 1;
+	while (data.size() < Size) {
+		state = state * 1664525u + 1013904223u;
+		data += "value_" + std::to_string(state % 1000) + (state & 0x10000 ? ";\n" : ", ");
+	}
+	data.resize(Size);
+	return data;
+}
+
+/**
+ * Reads every file of an archive from N threads sharing one DatFile, for 1 thread up to twice the hardware threads
+ * Shows throughput growing with the thread count now that reads are positional and don't share a cursor
+ */
+static void benchThreads() {
+	const size_t fileCount = 256;
+	const size_t fileSize = 256 * 1024;
+
+	std::string archivePath = (scratchDirectory / "threads.dat").string();
+	{
+		DatFileWriter writer(archivePath);
+		for (size_t i = 0; i < fileCount; ++i) {
+			std::string source = writeSource("threads/" + std::to_string(i), makeData(fileSize, (uint32_t) i));
+			writer.writeFile(source, FileDescriptor(true, false, "threads/" + std::to_string(i)));
+		}
+		writer.finish();
+	}
+
+	std::cout << "threads: " << fileCount << " compressed files of " << fileSize / 1024 << "KB, each thread reads all of them" << std::endl;
+
+	unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (bool memoryMap : {false, true}) {
+		DatFile archive(archivePath, memoryMap);
+
+		std::vector<AssetHandle> handles;
+		for (size_t i = 0; i < fileCount; ++i) handles.push_back(archive.resolve("threads/" + std::to_string(i)));
+
+		double single = 0;
+		for (unsigned threadCount = 1; threadCount <= hardwareThreads * 2; threadCount *= 2) {
+			std::atomic<bool> failed{false};
+			double seconds = timeSeconds([&]() {
+				std::vector<std::thread> threads;
+				for (unsigned t = 0; t < threadCount; ++t) {
+					threads.emplace_back([&, t]() {
+						std::vector<char> buffer(fileSize);
+						for (size_t i = 0; i < fileCount; ++i) {
+							if (!archive.getFile(handles[(i + t * 7) % fileCount], buffer.data())) failed = true;
+						}
+					});
+				}
+				for (std::thread& it : threads) it.join();
+			});
+
+			double throughput = (double) fileCount * fileSize * threadCount / seconds / (1024 * 1024);
+			if (threadCount == 1) single = throughput;
+
+			std::cout << "  " << (memoryMap ? "mapped" : "stream") << " threads " << std::setw(3) << threadCount << ": " << std::fixed << std::setprecision(1) << std::setw(8) << throughput << " MB/s, " << std::setprecision(2) << throughput / single << "x" << (failed ? " (reads failed)" : "") << std::endl;
+		}
+	}
+}
+
+/**
+ * Inflates thousands of 1-4KB entries with a new inflate stream for each, then with the calling thread's DatInflater
+ * Shows the per-entry cost saved by resetting one stream rather than setting up and tearing down a new one, then times whole reads through DatFile
+ */
+static void benchInflate() {
+	const size_t entryCount = 4096;
+	const int rounds = 20;
+
+	std::vector<std::string> entries;
+	std::vector<std::vector<Bytef>> compressed;
+	for (size_t i = 0; i < entryCount; ++i) {
+		entries.push_back(makeData(1024 + (i * 977) % 3072, (uint32_t) i));
+
+		uLongf compressedSize = compressBound((uLong) entries.back().size());
+		compressed.emplace_back(compressedSize);
+		compress2(compressed.back().data(), &compressedSize, reinterpret_cast<const Bytef*>(entries.back().data()), (uLong) entries.back().size(), Z_DEFAULT_COMPRESSION);
+		compressed.back().resize(compressedSize);
+	}
+
+	std::cout << "inflate: " << entryCount << " entries of 1-4KB, " << rounds << " rounds" << std::endl;
+
+	std::vector<char> buffer(4096);
+	bool failed = false;
+
+	auto inflateEntry = [&](z_stream* Stream, size_t Index) {
+		Stream->next_in = compressed[Index].data();
+		Stream->avail_in = (uInt) compressed[Index].size();
+		Stream->next_out = reinterpret_cast<Bytef*>(buffer.data());
+		Stream->avail_out = (uInt) buffer.size();
+		if (inflate(Stream, Z_FINISH) != Z_STREAM_END || Stream->total_out != entries[Index].size()) failed = true;
+	};
+
+	double fresh = timeSeconds([&]() {
+		for (int round = 0; round < rounds; ++round) {
+			for (size_t i = 0; i < entryCount; ++i) {
+				z_stream strm{};
+				if (inflateInit(&strm) != Z_OK) failed = true;
+				inflateEntry(&strm, i);
+				inflateEnd(&strm);
+			}
+		}
+	});
+
+	double reused = timeSeconds([&]() {
+		for (int round = 0; round < rounds; ++round) {
+			for (size_t i = 0; i < entryCount; ++i) {
+				z_stream* strm;
+				if (DatInflater::forThread().begin(strm) != Z_OK) failed = true;
+				inflateEntry(strm, i);
+			}
+		}
+	});
+
+	// The same entries read whole through an archive, which uses the reused inflater
+	std::string archivePath = (scratchDirectory / "inflate.dat").string();
+	{
+		DatFileWriter writer(archivePath);
+		for (size_t i = 0; i < entryCount; ++i) {
+			writer.writeFile(writeSource("inflate/" + std::to_string(i), entries[i]), FileDescriptor(true, false, "inflate/" + std::to_string(i)));
+		}
+		writer.finish();
+	}
+
+	DatFile archive(archivePath);
+	std::vector<AssetHandle> handles;
+	for (size_t i = 0; i < entryCount; ++i) handles.push_back(archive.resolve("inflate/" + std::to_string(i)));
+
+	double reads = timeSeconds([&]() {
+		for (int round = 0; round < rounds; ++round) {
+			for (AssetHandle it : handles) {
+				if (!archive.getFile(it, buffer.data())) failed = true;
+			}
+		}
+	});
+
+	double perEntry = 1e9 / ((double) entryCount * rounds);
+	std::cout << std::fixed << std::setprecision(0);
+	std::cout << "  new stream per entry: " << std::setw(8) << fresh * perEntry << " ns/entry" << std::endl;
+	std::cout << "  reused DatInflater:   " << std::setw(8) << reused * perEntry << " ns/entry, saving " << (fresh - reused) * perEntry << " ns/entry" << std::endl;
+	std::cout << "  DatFile::getFile:     " << std::setw(8) << reads * perEntry << " ns/entry" << (failed ? " (inflates failed)" : "") << std::endl;
+}
+
+/**
+ * Opens archives of 10k, 100k, and 1M entries, in both modes
+ * Shows what reading the table in one go and using it in place costs at startup
+ */
+static void benchOpen() {
+	const int opens = 5;
+	std::string source = writeSource("open", "data");
+
+	std::cout << "open: best of " << opens << " opens" << std::endl;
+
+	for (size_t entryCount : {(size_t) 10000, (size_t) 100000, (size_t) 1000000}) {
+		std::string archivePath = (scratchDirectory / ("open" + std::to_string(entryCount) + ".dat")).string();
+		{
+			DatFileWriter writer(archivePath);
+			for (size_t i = 0; i < entryCount; ++i) {
+				writer.writeFile(source, FileDescriptor(false, false, "scripts/module" + std::to_string(i / 100) + "/file" + std::to_string(i) + ".lua"));
+			}
+			writer.finish();
+		}
+
+		for (bool memoryMap : {false, true}) {
+			double best = 0;
+			bool failed = false;
+			for (int i = 0; i < opens; ++i) {
+				DatFile archive;
+				double seconds = timeSeconds([&]() {
+					if (!archive.openFile(archivePath, memoryMap) || !archive.contains("scripts/module0/file0.lua")) failed = true;
+				});
+				if (i == 0 || seconds < best) best = seconds;
+			}
+
+			std::cout << "  " << std::setw(7) << entryCount << " entries " << (memoryMap ? "mapped" : "stream") << ": " << std::fixed << std::setprecision(3) << std::setw(9) << best * 1000 << " ms" << (failed ? " (open failed)" : "") << std::endl;
+		}
+
+		std::filesystem::remove(archivePath);
+	}
+}
+
+/**
+ * Checksums 4KB, 1MB, and 256MB buffers with each CRC32 kernel the CPU can run, and with XXH64
+ * Every kernel goes through about 1GB of data per buffer size, and its CRCs are checked against ZLib's
+ */
+static void benchChecksum() {
+	const size_t totalBytes = (size_t) 1024 * 1024 * 1024;
+
+	std::vector<std::pair<std::string, DatCrc32::Kernel>> kernels = {{"zlib", DatCrc32::zlibKernel}};
+#ifdef DATCHECKSUM_X86
+	if (DatCrc32::hasPclmul()) kernels.emplace_back("pclmul", DatCrc32::pclmulKernel);
+#endif
+#ifdef DATCHECKSUM_ARM
+	if (DatCrc32::hasArmCrc()) kernels.emplace_back("armv8 crc", DatCrc32::armKernel);
+#endif
+
+	std::cout << "checksum: about 1GB per kernel and buffer size" << std::endl;
+
+	for (size_t bufferSize : {(size_t) 4 * 1024, (size_t) 1024 * 1024, (size_t) 256 * 1024 * 1024}) {
+		std::vector<unsigned char> buffer(bufferSize);
+		uint32_t state = 1;
+		for (unsigned char& it : buffer) {
+			state = state * 1664525u + 1013904223u;
+			it = (unsigned char) (state >> 24);
+		}
+
+		size_t rounds = std::max<size_t>(1, totalBytes / bufferSize);
+		uint32_t expected = DatCrc32::zlibKernel(0, buffer.data(), bufferSize);
+
+		auto report = [&](const std::string& Name, double Seconds, bool Matches) {
+			std::cout << "  " << std::setw(6) << (bufferSize >= 1024 * 1024 ? std::to_string(bufferSize / (1024 * 1024)) + "MB" : std::to_string(bufferSize / 1024) + "KB") << " " << std::left << std::setw(10) << Name << std::right << ": " << std::fixed << std::setprecision(2) << std::setw(7) << (double) bufferSize * rounds / Seconds / (1024.0 * 1024 * 1024) << " GB/s" << (Matches ? "" : " (wrong CRC)") << std::endl;
+		};
+
+		for (const auto& kernel : kernels) {
+			uint32_t crc = 0;
+			double seconds = timeSeconds([&]() {
+				for (size_t i = 0; i < rounds; ++i) crc = kernel.second(0, buffer.data(), bufferSize);
+			});
+			report(kernel.first, seconds, crc == expected);
+		}
+
+		uint64_t hash = 0;
+		double seconds = timeSeconds([&]() {
+			for (size_t i = 0; i < rounds; ++i) hash += DatXxh64::hash(buffer.data(), bufferSize);
+		});
+		resultSink = hash;
+		report("xxh64", seconds, true);
+	}
+}
+
+int main(int argc, char** argv) {
+	scratchDirectory = std::filesystem::temp_directory_path() / "DatBench";
+	std::filesystem::remove_all(scratchDirectory);
+	std::filesystem::create_directories(scratchDirectory);
+
+	std::vector<std::pair<std::string, void (*)()>> benchmarks = {
+		{"threads", benchThreads},
+		{"inflate", benchInflate},
+		{"open", benchOpen},
+		{"checksum", benchChecksum},
+	};
+
+	for (const auto& it : benchmarks) {
+		bool wanted = argc < 2;
+		for (int i = 1; i < argc; ++i) {
+			if (it.first == argv[i]) wanted = true;
+		}
+		if (wanted) it.second();
+	}
+
+	std::filesystem::remove_all(scratchDirectory);
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include <DatArchiveWriter.h>
+#include <DatArchive.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Checks that looking a file up and reading it into a caller's buffer doesn't touch the heap, whether the path is a string_view, a C string, or a handle
+ * Every allocation in the program is counted by replacing the global operator new
+ */
+
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t Size) {
+	++allocations;
+	if (void* memory = malloc(Size != 0 ? Size : 1)) return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t Size) {
+	return operator new(Size);
+}
+
+void operator delete(void* Memory) noexcept {
+	free(Memory);
+}
+
+void operator delete[](void* Memory) noexcept {
+	free(Memory);
+}
+
+void operator delete(void* Memory, size_t) noexcept {
+	free(Memory);
+}
+
+void operator delete[](void* Memory, size_t) noexcept {
+	free(Memory);
+}
+
+int main() {
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "DatAllocationTest";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	std::string compressedSource = (directory / "compressed.txt").string();
+	std::string storedSource = (directory / "stored.txt").string();
+	std::ofstream(compressedSource) << std::string(100000, 'x');
+	std::ofstream(storedSource) << "hello world";
+
+	std::string archivePath = (directory / "archive" / "allocation.dat").string();
+	{
+		DatFileWriter writer(archivePath);
+		writer.writeFile(compressedSource, FileDescriptor(true, false, "textures/compressed.txt"));
+		writer.writeFile(storedSource, FileDescriptor(false, false, "scripts/stored.txt"));
+		writer.finish();
+	}
+
+	bool success = true;
+	for (bool memoryMap : {false, true}) {
+		DatFile archive(archivePath, memoryMap);
+		std::vector<char> buffer(100000);
+
+		// The first read sets up the thread's inflater
+		success = archive.getFile("textures/compressed.txt", buffer.data()) && success;
+
+		std::string_view compressed = "textures/compressed.txt";
+		const char* stored = "scripts/stored.txt";
+
+		size_t before = allocations;
+		bool read = true;
+		for (int i = 0; i < 100; ++i) {
+			read = archive.contains(compressed) && read;
+			read = archive.getFileHeader(compressed).dataSize == 100000 && read;
+			read = archive.getFile(compressed, buffer.data()) && read;
+			read = archive.getFile(stored, buffer.data()) && read;
+			read = archive.getFile(archive.resolve(stored), buffer.data()) && read;
+		}
+		size_t made = allocations - before;
+
+		if (!read || made != 0) {
+			std::cout << (memoryMap ? "Mapped" : "Streamed") << " lookups and reads made " << made << " allocations" << (read ? "" : ", and some reads failed") << std::endl;
+			success = false;
+		}
+	}
+
+	std::filesystem::remove_all(directory);
+	return success ? 0 : 1;
+}
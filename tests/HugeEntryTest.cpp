@@ -0,0 +1,129 @@
+#include <DatArchiveWriter.h>
+#include <DatArchive.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Packs a 6GB file as one compressed entry, then reads it back whole and as a stream, checking every size stays 64 bits on the way
+ * Needs about 6GB of free disk space and takes minutes, so it is only built with DATARCHIVE_LONG_TESTS
+ */
+
+static const int64_t ENTRYSIZE = (int64_t) 6 * 1024 * 1024 * 1024;
+
+// The source is all zeroes apart from these bytes, either side of the 4GB boundary and at both ends
+static const int64_t MARKS[] = {0, 1, ((int64_t) 4 << 30) - 1, (int64_t) 4 << 30, ((int64_t) 4 << 30) + 12345, ENTRYSIZE - 1};
+
+/**
+ * Gets the byte the source has at an offset
+ * @param Offset The offset in the source
+ * @return The byte
+ */
+static char expectedAt(int64_t Offset) {
+	for (int64_t it : MARKS) {
+		if (it == Offset) return (char) (Offset % 251 + 1);
+	}
+	return 0;
+}
+
+int main() {
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "DatHugeEntryTest";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	// The zeroes are left as a hole, so the source doesn't take up 6GB on filesystems with sparse files
+	std::string source = (directory / "huge.bin").string();
+	{
+		std::ofstream file(source, std::ios::binary);
+		for (int64_t it : MARKS) {
+			file.seekp(it);
+			file.put(expectedAt(it));
+		}
+	}
+
+	std::string archivePath = (directory / "archive" / "huge.dat").string();
+	{
+		DatFileWriter writer(archivePath);
+		if (!writer.writeFile(source, FileDescriptor(true, false, "huge"))) {
+			std::cout << "Couldn't pack the 6GB entry" << std::endl;
+			return 1;
+		}
+		writer.finish();
+	}
+	std::filesystem::remove(source);
+
+	bool success = true;
+	for (bool memoryMap : {false, true}) {
+		DatFile archive(archivePath, memoryMap);
+		const char* mode = memoryMap ? "Mapped" : "Streamed";
+
+		if (archive.getFileHeader("huge").dataSize != ENTRYSIZE) {
+			std::cout << mode << " archive has the wrong size for the entry" << std::endl;
+			success = false;
+			continue;
+		}
+
+		// Read whole into a mapping of a file, as the entry is bigger than the memory of most machines running this
+#if defined(__unix__) || defined(__APPLE__)
+		std::string outputPath = (directory / "output.bin").string();
+		int output = open(outputPath.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+		if (output == -1 || ftruncate(output, ENTRYSIZE) != 0) {
+			std::cout << "Couldn't make a 6GB file to read the entry into" << std::endl;
+			return 1;
+		}
+
+		void* mapping = mmap(nullptr, (size_t) ENTRYSIZE, PROT_READ | PROT_WRITE, MAP_SHARED, output, 0);
+		if (mapping == MAP_FAILED) {
+			std::cout << "Couldn't map a 6GB file to read the entry into" << std::endl;
+			return 1;
+		}
+
+		char* buffer = static_cast<char*>(mapping);
+		buffer[2] = 1;
+
+		bool read = archive.getFile("huge", buffer);
+		for (int64_t it : MARKS) {
+			read = read && buffer[it] == expectedAt(it);
+		}
+		read = read && buffer[2] == 0 && buffer[(int64_t) 5 << 30] == 0;
+
+		if (!read) {
+			std::cout << mode << " read of the whole entry failed" << std::endl;
+			success = false;
+		}
+
+		munmap(mapping, (size_t) ENTRYSIZE);
+		close(output);
+		std::filesystem::remove(outputPath);
+#endif
+
+		// Read back as a stream, checking every byte, the marks are the only bytes that aren't zero
+		DatEntryReader reader = archive.openStream("huge");
+		int64_t offset = 0;
+		size_t marksFound = 0;
+		bool matches = true;
+		while (true) {
+			DatByteView chunk = reader.readChunk();
+			if (chunk.empty()) break;
+
+			for (size_t i = 0; i < chunk.size(); ++i) {
+				if (chunk.data()[i] == std::byte{0}) continue;
+
+				++marksFound;
+				if ((char) chunk.data()[i] != expectedAt(offset + (int64_t) i)) matches = false;
+			}
+			offset += (int64_t) chunk.size();
+		}
+
+		if (reader.failed() || offset != ENTRYSIZE || !matches || marksFound != std::size(MARKS)) {
+			std::cout << mode << " stream of the entry failed after " << offset << " bytes" << std::endl;
+			success = false;
+		}
+	}
+
+	std::filesystem::remove_all(directory);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+#include <DatArchiveWriter.h>
+#include <DatArchive.h>
+
+/**
+ * Writes archives of every version in each way files can be stored, then reads every file back through getFile, readRange and openStream, with and without memory mapping
+ * Then flips a byte in each archive, and checks reads that touch it fail rather than hand out the wrong data
+ */
+
+static std::filesystem::path directory;
+static bool success = true;
+
+// The ways files are written, each needing a minimum archive version
+static const int MODESTORED = 0;
+static const int MODECOMPRESSED = 1;
+static const int MODESEEKABLE = 2;
+static const int MODECODEC = 3;
+static const int MODEDICTIONARY = 4;
+static const int MODESOLID = 5;
+static const int MODECOUNT = 6;
+
+static const char* MODENAMES[MODECOUNT] = {"stored", "compressed", "seekable", "lz4", "dictionary", "solid"};
+static const uint8_t MODEVERSIONS[MODECOUNT] = {0x02, 0x02, 0x02, 0x06, 0x07, 0x08};
+
+struct TestFile {
+	std::string name;
+	std::string data;
+	FileDescriptor descriptor;
+};
+
+/**
+ * Reports a failed check, and fails the test
+ * @param Passed Whether the check passed
+ * @param Archive The archive being checked
+ * @param What What was checked
+ */
+static void check(bool Passed, const std::string& Archive, const std::string& What) {
+	if (Passed) return;
+
+	std::cout << Archive << ": " << What << std::endl;
+	success = false;
+}
+
+/**
+ * Makes data that compresses, with a bit in common between seeds for the dictionaries to find
+ * @param Size The amount of bytes
+ * @param Seed Varies the data
+ * @return The data
+ */
+static std::string makeData(size_t Size, uint32_t Seed) {
+	std::string data;
+	data.reserve(Size + 32);
+
+	uint32_t state = Seed * 2654435761u + 1;
+	while (data.size() < Size) {
+		state = state * 1664525u + 1013904223u;
+		data += (state & 0x30000) == 0 ? "uniform vec4 colour;\n" : "v" + std::to_string(state % 5000) + (state & 0x10000 ? ";\n" : ", ");
+	}
+	data.resize(Size);
+	return data;
+}
+
+/**
+ * Makes the files for a mode
+ * @param Mode The MODE value
+ * @return The files, all going in one archive
+ */
+static std::vector<TestFile> makeFiles(int Mode) {
+	std::vector<TestFile> files;
+	auto add = [&](const std::string& Name, size_t Size, FileDescriptor Descriptor) {
+		files.push_back({Name, makeData(Size, (uint32_t) files.size() + 1), std::move(Descriptor)});
+		files.back().descriptor.destDirectory = Name;
+	};
+
+	const size_t sizes[] = {0, 1, 100, 50000, (size_t) DATFILEBLOCKSIZE * 5 / 2};
+	switch (Mode) {
+		case MODESTORED:
+		case MODECOMPRESSED:
+			for (size_t it : sizes) add("files/" + std::to_string(it) + ".bin", it, FileDescriptor(Mode == MODECOMPRESSED, false, ""));
+			break;
+		case MODESEEKABLE:
+			for (bool compressed : {false, true}) {
+				for (size_t it : {(size_t) DATFILEBLOCKSIZE * 5 / 2, (size_t) DATFILEBLOCKSIZE * 3 + 17}) {
+					add(std::string(compressed ? "compressed/" : "stored/") + std::to_string(it) + ".bin", it, FileDescriptor(compressed, false, "", true));
+				}
+			}
+			break;
+		case MODECODEC:
+			for (size_t it : sizes) add("lz4/" + std::to_string(it) + ".bin", it, FileDescriptor(true, false, "", false, DATCODECLZ4));
+			break;
+		case MODEDICTIONARY:
+			for (size_t i = 0; i < 24; ++i) add("shaders/" + std::to_string(i) + ".glsl", 200 + i * 150, FileDescriptor(true, false, "", false, DATCODECZLIB, 5));
+			add("shaders/empty.glsl", 0, FileDescriptor(true, false, "", false, DATCODECZLIB, 5));
+			break;
+		case MODESOLID:
+			for (size_t i = 0; i < 60; ++i) add("scripts/" + std::to_string(i) + ".lua", (i * 937) % 5000, FileDescriptor(true, false, "", false, DATCODECZLIB, (uint8_t) (i % 2)));
+			add("scripts/big.lua", 100000, FileDescriptor(true, false, ""));
+			break;
+	}
+
+	return files;
+}
+
+/**
+ * Writes an archive
+ * @param Path Where to write it
+ * @param Version The version to write
+ * @param Checksum The checksum to give the files
+ * @param Mode The MODE value
+ * @param Files The files to write
+ * @return Whether the archive was written
+ */
+static bool writeArchive(const std::string& Path, uint8_t Version, uint8_t Checksum, int Mode, const std::vector<TestFile>& Files) {
+	DatFileWriter writer(Path, true, Version);
+	bool written = writer.setChecksum(Checksum);
+
+	if (Mode == MODESOLID) written = writer.setSolidBlocks(8 * 1024, 32 * 1024) && written;
+	if (Mode == MODEDICTIONARY) {
+		std::string sample = makeData(16 * 1024, 1000);
+		written = writer.setDictionary(5, std::vector<char>(sample.begin(), sample.end())) && written;
+	}
+
+	for (const TestFile& it : Files) {
+		std::string source = (directory / "source.bin").string();
+		std::ofstream(source, std::ios::binary).write(it.data.data(), (std::streamsize) it.data.size());
+		written = writer.writeFile(source, it.descriptor) && written;
+	}
+
+	return writer.finish() && written;
+}
+
+/**
+ * Reads a whole file through openStream
+ * @param Archive The archive to read from
+ * @param Name The file to read
+ * @param Data Where to put what was read
+ * @return Whether the reader got to the end without failing
+ */
+static bool streamFile(const DatFile& Archive, const std::string& Name, std::string& Data) {
+	DatEntryReader reader = Archive.openStream(Name);
+
+	char buffer[10000];
+	size_t length;
+	while ((length = reader.read(buffer, sizeof(buffer))) > 0) Data.append(buffer, length);
+
+	return !reader.failed() && reader.tell() == reader.size();
+}
+
+/**
+ * Reads every file back, and some ranges out of each, checking they match what was written
+ * @param Path The archive
+ * @param Files The files written to it
+ */
+static void checkArchive(const std::string& Path, const std::vector<TestFile>& Files) {
+	for (bool memoryMap : {false, true}) {
+		DatFile archive;
+		std::string name = Path + (memoryMap ? " mapped" : " streamed");
+		check(archive.openFile(Path, memoryMap), name, "couldn't be opened");
+		check(archive.size() == Files.size(), name, "has the wrong amount of files");
+		archive.setVerifyPolicy(DATVERIFYALWAYS);
+
+		for (const TestFile& it : Files) {
+			std::vector<char> data = archive.getFile(it.name);
+			check(archive.contains(it.name) && std::string(data.begin(), data.end()) == it.data, name, "getFile of " + it.name + " doesn't match");
+
+			std::string streamed;
+			check(streamFile(archive, it.name, streamed) && streamed == it.data, name, "openStream of " + it.name + " doesn't match");
+
+			// The start, the middle, the last byte, the whole file, and across the first block boundary
+			int64_t size = (int64_t) it.data.size();
+			std::vector<std::pair<int64_t, int64_t>> ranges = {{0, std::min<int64_t>(size, 16)}, {size / 2, std::min<int64_t>(size - size / 2, 4096)}, {size - 1, 1}, {0, size}};
+			if (size > DATFILEBLOCKSIZE) ranges.emplace_back(DATFILEBLOCKSIZE - 100, 300);
+
+			for (const auto& range : ranges) {
+				if (range.first < 0 || range.second <= 0) continue;
+
+				std::vector<char> buffer((size_t) range.second);
+				bool read = archive.readRange(it.name, range.first, buffer.size(), buffer.data());
+				check(read && std::string(buffer.begin(), buffer.end()) == it.data.substr((size_t) range.first, (size_t) range.second), name, "readRange of " + it.name + " at " + std::to_string(range.first) + " doesn't match");
+			}
+		}
+	}
+}
+
+/**
+ * Flips a byte inside the biggest file, or in the middle of the data when files are in solid blocks, then checks the reads that touch it fail
+ * Every other read has to still hand out the right data
+ * @param Path The archive
+ * @param Mode The MODE value
+ * @param Files The files written to it
+ */
+static void checkCorruption(const std::string& Path, int Mode, const std::vector<TestFile>& Files) {
+	std::string corruptPath = Path + ".corrupt";
+	std::filesystem::copy_file(Path, corruptPath, std::filesystem::copy_options::overwrite_existing);
+
+	const TestFile* target = nullptr;
+	int64_t position;
+	{
+		DatFile archive(Path);
+		if (Mode == MODESOLID) {
+			int64_t tableOffset;
+			std::ifstream file(Path, std::ios::binary);
+			file.seekg(5);
+			file.read(reinterpret_cast<char*>(&tableOffset), 8);
+			position = 13 + (tableOffset - 13) / 2;
+		} else {
+			target = &*std::max_element(Files.begin(), Files.end(), [](const TestFile& A, const TestFile& B) {
+				return A.data.size() < B.data.size();
+			});
+			DatFileEntry entry = archive.getFileHeader(target->name);
+			position = entry.dataStart + (entry.dataEnd - entry.dataStart) / 2;
+		}
+	}
+
+	{
+		std::fstream file(corruptPath, std::ios::binary | std::ios::in | std::ios::out);
+		char byte;
+		file.seekg(position);
+		file.get(byte);
+		file.seekp(position);
+		file.put((char) (byte ^ 0x5A));
+	}
+
+	for (bool memoryMap : {false, true}) {
+		DatFile archive(corruptPath, memoryMap);
+		std::string name = corruptPath + (memoryMap ? " mapped" : " streamed");
+		archive.setVerifyPolicy(DATVERIFYALWAYS);
+
+		size_t failures = 0;
+		for (const TestFile& it : Files) {
+			std::vector<char> data = archive.getFile(it.name);
+			bool read = std::string(data.begin(), data.end()) == it.data;
+
+			std::string streamed;
+			bool streamRead = streamFile(archive, it.name, streamed);
+			check(!streamRead || streamed == it.data, name, "openStream of " + it.name + " handed out corrupt data");
+
+			std::vector<char> buffer(it.data.size());
+			bool rangeRead = !buffer.empty() && archive.readRange(it.name, 0, buffer.size(), buffer.data());
+			check(!rangeRead || std::string(buffer.begin(), buffer.end()) == it.data, name, "readRange of " + it.name + " handed out corrupt data");
+
+			if (&it == target) check(!read && !streamRead && !rangeRead, name, "reads of the corrupted " + it.name + " didn't fail");
+			if (!read && !it.data.empty()) ++failures;
+		}
+
+		check(failures > 0, name, "no read noticed the flipped byte");
+	}
+}
+
+int main() {
+	directory = std::filesystem::temp_directory_path() / "DatRoundTripTest";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory / "archives");
+
+	for (uint8_t version = DATFILEMINVERSION; version <= DATFILEVERSION; ++version) {
+		for (uint8_t checksum = DATCHECKSUMCRC32; checksum <= (version >= 0x09 ? DATCHECKSUMXXH64 : DATCHECKSUMCRC32); ++checksum) {
+			for (int mode = 0; mode < MODECOUNT; ++mode) {
+				if (version < MODEVERSIONS[mode]) continue;
+
+				std::string path = (directory / "archives" / ("v" + std::to_string(version) + "-" + MODENAMES[mode] + (checksum == DATCHECKSUMXXH64 ? "-xxh64" : "") + ".dat")).string();
+				std::vector<TestFile> files = makeFiles(mode);
+
+				if (!writeArchive(path, version, checksum, mode, files)) {
+					check(false, path, "couldn't be written");
+					continue;
+				}
+
+				checkArchive(path, files);
+				checkCorruption(path, mode, files);
+			}
+		}
+	}
+
+	std::filesystem::remove_all(directory);
+	if (success) std::cout << "Every archive read back correctly" << std::endl;
+	return success ? 0 : 1;
+}